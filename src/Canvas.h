@@ -0,0 +1,130 @@
+#pragma once
+
+// One logical LED canvas spread over several physical strips (SmartLed, Apa102, LDP8806,
+// in any mix). Effects draw into a single contiguous Rgb buffer, show() scatters it
+// to the strips through precomputed index tables and starts all of them at once, so
+// the RMT channels and SPI hosts transmit in parallel.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+#include "Color.h"
+#include "Segments.h"
+
+class Canvas {
+public:
+    static constexpr const int MAX_OUTPUTS = 12;
+
+    // Up to 65536 pixels, the index tables are 16-bit
+    Canvas(int count)
+        : _count(count)
+        , _next(0)
+        , _outputCount(0)
+        , _pixels(new Rgb[count]) {
+        assert(count >= 0 && count <= 65536);
+    }
+
+    // Strip pixel i shows canvas pixel range.physical(i). The strip may be longer
+    // than the range, the rest of it is left alone.
+    template <class Strip>
+    bool attach(Strip& strip, SegmentRange range) {
+        if (_outputCount == MAX_OUTPUTS || range.length > strip.size())
+            return false;
+        for (int i = 0; i != range.length; i++) {
+            int p = range.physical(i);
+            if (p < 0 || p >= _count)
+                return false;
+        }
+
+        auto& out = _outputs[_outputCount++];
+        out.strip = &strip;
+        out.count = range.length;
+        out.map.reset(new uint16_t[range.length]);
+        for (int i = 0; i != range.length; i++)
+            out.map[i] = range.physical(i);
+        out.scatter = scatterTo<Strip>;
+        out.show = showOf<Strip>;
+        out.wait = waitOf<Strip>;
+        _next = std::max(_next, range.start + (range.length - 1) * range.stride + 1);
+        return true;
+    }
+
+    // Appends the whole strip after the last attached pixel
+    template <class Strip>
+    bool attach(Strip& strip, bool reversed = false) {
+        return attach(strip, SegmentRange { _next, strip.size(), 1, reversed });
+    }
+
+    int size() const { return _count; }
+    int outputCount() const { return _outputCount; }
+
+    Rgb& operator[](int idx) { return _pixels[idx]; }
+    const Rgb& operator[](int idx) const { return _pixels[idx]; }
+
+    Rgb* begin() { return _pixels.get(); }
+    const Rgb* begin() const { return _pixels.get(); }
+    Rgb* end() { return _pixels.get() + _count; }
+    const Rgb* end() const { return _pixels.get() + _count; }
+
+    // Waits for the strips to finish the previous frame, then sends this one to all of them
+    esp_err_t show() {
+        wait();
+        esp_err_t err = ESP_OK;
+        for (int i = 0; i != _outputCount; i++)
+            _outputs[i].scatter(_outputs[i].strip, _pixels.get(), _outputs[i].map.get(), _outputs[i].count);
+        for (int i = 0; i != _outputCount; i++) {
+            auto e = _outputs[i].show(_outputs[i].strip);
+            if (err == ESP_OK)
+                err = e;
+        }
+        return err;
+    }
+
+    // The timeout applies to each of the strips
+    bool wait(TickType_t timeout = portMAX_DELAY) {
+        bool done = true;
+        for (int i = 0; i != _outputCount; i++)
+            done = _outputs[i].wait(_outputs[i].strip, timeout) && done;
+        return done;
+    }
+
+    bool ready() { return wait(0); }
+
+private:
+    struct Output {
+        void* strip;
+        int count;
+        std::unique_ptr<uint16_t[]> map;
+        void (*scatter)(void*, const Rgb*, const uint16_t*, int);
+        esp_err_t (*show)(void*);
+        bool (*wait)(void*, TickType_t);
+    };
+
+    template <class Strip>
+    static void scatterTo(void* strip, const Rgb* src, const uint16_t* map, int count) {
+        auto* dest = &(*static_cast<Strip*>(strip))[0];
+        for (int i = 0; i != count; i++)
+            dest[i] = src[map[i]];
+    }
+
+    template <class Strip>
+    static esp_err_t showOf(void* strip) {
+        return static_cast<Strip*>(strip)->show();
+    }
+
+    template <class Strip>
+    static bool waitOf(void* strip, TickType_t timeout) {
+        return static_cast<Strip*>(strip)->wait(timeout);
+    }
+
+    int _count;
+    int _next;
+    int _outputCount;
+    std::unique_ptr<Rgb[]> _pixels;
+    Output _outputs[MAX_OUTPUTS];
+};
@@ -90,3 +90,13 @@ union Hsv {
     bool operator==(const Hsv& in) const { return in.value == value; }
     void swap(const Hsv& o) { value = o.value; }
 };
+
+// 16 bits per channel, used where the LEDs can show more than 8 bits (e.g. Apa102::convertHdr)
+struct Rgb16 {
+    Rgb16(uint16_t r = 0, uint16_t g = 0, uint16_t b = 0)
+        : r(r)
+        , g(g)
+        , b(b) {}
+
+    uint16_t r, g, b;
+};
@@ -0,0 +1,73 @@
+#include "Compositor.h"
+#include "FixedMath.h"
+
+#include <algorithm>
+
+namespace {
+
+struct Normal {
+    static uint8_t apply(uint8_t, uint8_t s) { return s; }
+};
+
+struct Add {
+    static uint8_t apply(uint8_t d, uint8_t s) { return std::min(255, d + s); }
+};
+
+// 1 - (1 - d) * (1 - s)
+struct Screen {
+    static uint8_t apply(uint8_t d, uint8_t s) { return 255 - smartleds::scale8(255 - d, 255 - s); }
+};
+
+struct Multiply {
+    static uint8_t apply(uint8_t d, uint8_t s) { return smartleds::scale8(d, s); }
+};
+
+struct Max {
+    static uint8_t apply(uint8_t d, uint8_t s) { return std::max(d, s); }
+};
+
+template <class Mode>
+void blendWith(Rgb* dest, const Rgb* src, int count, uint8_t opacity) {
+    for (int i = 0; i != count; i++) {
+        Rgb& d = dest[i];
+        const Rgb& s = src[i];
+        const uint8_t alpha = smartleds::scale8(s.a, opacity);
+        if (alpha == 255) {
+            d.r = Mode::apply(d.r, s.r);
+            d.g = Mode::apply(d.g, s.g);
+            d.b = Mode::apply(d.b, s.b);
+            continue;
+        }
+        if (alpha == 0)
+            continue;
+        d.r = smartleds::lerp8(d.r, Mode::apply(d.r, s.r), alpha);
+        d.g = smartleds::lerp8(d.g, Mode::apply(d.g, s.g), alpha);
+        d.b = smartleds::lerp8(d.b, Mode::apply(d.b, s.b), alpha);
+    }
+}
+
+} // namespace
+
+void Compositor::blend(Rgb* dest, const Rgb* src, int count, BlendMode mode, uint8_t opacity) {
+    if (opacity == 0)
+        return;
+    switch (mode) {
+    case BlendNormal:
+        return blendWith<Normal>(dest, src, count, opacity);
+    case BlendAdd:
+        return blendWith<Add>(dest, src, count, opacity);
+    case BlendScreen:
+        return blendWith<Screen>(dest, src, count, opacity);
+    case BlendMultiply:
+        return blendWith<Multiply>(dest, src, count, opacity);
+    case BlendMax:
+        return blendWith<Max>(dest, src, count, opacity);
+    }
+}
+
+void Compositor::flattenChunk(Rgb* acc, int offset, int count) const {
+    for (int i = 0; i != count; i++)
+        acc[i] = Rgb(0, 0, 0);
+    for (int l = 0; l != _layerCount; l++)
+        blend(acc, _layers[l].pixels.get() + offset, count, _layers[l].mode, _layers[l].opacity);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Stack of full-strip Rgb layers flattened into a strip once per frame. Flattening goes
+// in chunks which stay in cache while all the layers are blended into them, so the
+// output is written once instead of once per layer.
+
+#include <memory>
+
+#include "Color.h"
+#include "LedOutput.h"
+
+enum BlendMode { BlendNormal = 0, BlendAdd, BlendScreen, BlendMultiply, BlendMax };
+
+class Compositor {
+public:
+    static constexpr const int MAX_LAYERS = 8;
+    static constexpr const int CHUNK = 64;
+
+    Compositor(int count)
+        : _count(count)
+        , _layerCount(0) {}
+
+    // Returns index of the new layer (cleared to black), or -1 if there are MAX_LAYERS already.
+    // Layers are stacked in the order they are added, the first one is over black.
+    int addLayer(BlendMode mode = BlendNormal, uint8_t opacity = 255) {
+        if (_layerCount == MAX_LAYERS)
+            return -1;
+        auto& l = _layers[_layerCount];
+        l.pixels.reset(new Rgb[_count]);
+        for (int i = 0; i != _count; i++)
+            l.pixels[i] = Rgb(0, 0, 0);
+        l.mode = mode;
+        l.opacity = opacity;
+        return _layerCount++;
+    }
+
+    int size() const { return _count; }
+    int layerCount() const { return _layerCount; }
+
+    // Render target of the layer. The alpha of the pixels multiplies the layer opacity.
+    LedSpan<Rgb> layer(int idx) { return LedSpan<Rgb>(_layers[idx].pixels.get(), _count); }
+
+    void setOpacity(int idx, uint8_t opacity) { _layers[idx].opacity = opacity; }
+    uint8_t opacity(int idx) const { return _layers[idx].opacity; }
+    void setMode(int idx, BlendMode mode) { _layers[idx].mode = mode; }
+    BlendMode mode(int idx) const { return _layers[idx].mode; }
+
+    // Blends the layers into out (any strip, its first size() pixels)
+    template <class Strip>
+    void flatten(Strip& out) const {
+        Rgb acc[CHUNK];
+        auto* dest = &out[0];
+        for (int offset = 0; offset < _count; offset += CHUNK) {
+            const int n = _count - offset < CHUNK ? _count - offset : CHUNK;
+            flattenChunk(acc, offset, n);
+            for (int i = 0; i != n; i++)
+                dest[offset + i] = acc[i];
+        }
+    }
+
+    // Blends src over dest with the given mode and opacity, the pixel alpha applies too
+    static void blend(Rgb* dest, const Rgb* src, int count, BlendMode mode, uint8_t opacity);
+
+private:
+    struct Layer {
+        std::unique_ptr<Rgb[]> pixels;
+        BlendMode mode;
+        uint8_t opacity;
+    };
+
+    void flattenChunk(Rgb* acc, int offset, int count) const;
+
+    int _count;
+    int _layerCount;
+    Layer _layers[MAX_LAYERS];
+};
@@ -0,0 +1,89 @@
+#include "Effects.h"
+
+#include <algorithm>
+
+void EffectStats::add(uint32_t us) {
+    _samples[_frames % WINDOW] = std::min<uint32_t>(us, UINT16_MAX);
+    _frames++;
+    _lastUs = us;
+    _maxUs = std::max(_maxUs, us);
+    _totalUs += us;
+}
+
+void EffectStats::reset() {
+    _frames = 0;
+    _lastUs = 0;
+    _maxUs = 0;
+    _totalUs = 0;
+}
+
+uint32_t EffectStats::p99Us() const {
+    const int count = std::min<uint32_t>(_frames, WINDOW);
+    if (count == 0)
+        return 0;
+    uint16_t sorted[WINDOW];
+    std::copy(_samples, _samples + count, sorted);
+    // Smallest sample which at least 99 % of the samples don't exceed
+    const int idx = (count * 99 + 99) / 100 - 1;
+    std::nth_element(sorted, sorted + idx, sorted + count);
+    return sorted[idx];
+}
+
+int EffectEngine::add(Effect& effect, Effect* fallback) {
+    if (_count == MAX_EFFECTS)
+        return -1;
+    auto& slot = _slots[_count];
+    slot.effect = &effect;
+    slot.fallback = fallback;
+    slot.stats.reset();
+    slot.fallbackStats.reset();
+    slot.overruns = 0;
+    slot.degraded = false;
+    if (_current < 0)
+        _current = _count;
+    return _count++;
+}
+
+void EffectEngine::select(int idx) {
+    _current = idx;
+    _slots[idx].overruns = 0;
+    _slots[idx].degraded = false;
+}
+
+uint32_t EffectEngine::renderFrame(uint32_t timeMs) {
+    if (_current < 0)
+        return 0;
+    auto& slot = _slots[_current];
+    const bool fallback = slot.degraded;
+    Effect* effect = fallback ? slot.fallback : slot.effect;
+
+    const uint32_t start = _clock();
+    effect->render(_target, timeMs);
+    const uint32_t us = _clock() - start;
+
+    if (fallback) {
+        slot.fallbackStats.add(us);
+        return us;
+    }
+
+    slot.stats.add(us);
+    if (_budgetUs == 0 || us <= _budgetUs) {
+        slot.overruns = 0;
+    } else if (++slot.overruns >= OVERRUN_LIMIT && slot.fallback) {
+        slot.degraded = true;
+    }
+    return us;
+}
+
+EffectStats runEffect(
+    Effect& effect, LedSpan<Rgb> leds, int frames, uint32_t frameMs, Rgb* recording, EffectEngine::Clock clock) {
+    EffectStats stats;
+    for (int frame = 0; frame != frames; frame++) {
+        const uint32_t start = clock();
+        effect.render(leds, frame * frameMs);
+        stats.add(clock() - start);
+        if (recording)
+            recording = std::copy(leds.begin(), leds.end(), recording);
+    }
+    return stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// Effect plug-ins with per-frame timing. The engine renders the selected effect into a
+// LedSpan (e.g. ledSpan(smartLed)) and measures every frame. When an effect overruns
+// the frame budget several frames in a row, the engine switches to the effect's
+// cheaper fallback, so a single slow effect doesn't make the whole installation drop frames.
+
+#include <cstdint>
+
+#include <esp_timer.h>
+
+#include "Color.h"
+#include "LedOutput.h"
+
+class Effect {
+public:
+    virtual ~Effect() = default;
+
+    // Draws the frame for the given time. Must fill the whole target.
+    virtual void render(LedSpan<Rgb> leds, uint32_t timeMs) = 0;
+
+    virtual const char* name() const { return "effect"; }
+};
+
+// Render times of an effect. Average and maximum are since the last reset(),
+// the 99th percentile is over the last WINDOW frames (kept as 16-bit, i.e. up to 65 ms).
+class EffectStats {
+public:
+    static constexpr const int WINDOW = 128;
+
+    EffectStats() { reset(); }
+
+    void add(uint32_t us);
+    void reset();
+
+    uint32_t frames() const { return _frames; }
+    uint32_t lastUs() const { return _lastUs; }
+    uint32_t maxUs() const { return _maxUs; }
+    uint32_t averageUs() const { return _frames ? _totalUs / _frames : 0; }
+    uint32_t p99Us() const;
+
+private:
+    uint16_t _samples[WINDOW];
+    uint32_t _frames;
+    uint32_t _lastUs;
+    uint32_t _maxUs;
+    uint64_t _totalUs;
+};
+
+namespace detail {
+inline uint32_t timerMicros() { return esp_timer_get_time(); }
+} // namespace detail
+
+class EffectEngine {
+public:
+    static constexpr const int MAX_EFFECTS = 8;
+    // Consecutive frames over budget which make the engine switch to the fallback
+    static constexpr const int OVERRUN_LIMIT = 3;
+
+    using Clock = uint32_t (*)();
+
+    // budgetUs == 0 disables the watchdog. The clock returns microseconds.
+    EffectEngine(LedSpan<Rgb> target, uint32_t budgetUs = 0, Clock clock = detail::timerMicros)
+        : _target(target)
+        , _budgetUs(budgetUs)
+        , _clock(clock)
+        , _count(0)
+        , _current(-1) {}
+
+    // Returns the index of the effect, or -1 if there are MAX_EFFECTS already. The fallback
+    // is rendered instead of the effect once it overruns the budget.
+    int add(Effect& effect, Effect* fallback = nullptr);
+
+    // Selecting an effect gives it a new chance, even if it fell back before
+    void select(int idx);
+    int selected() const { return _current; }
+    int count() const { return _count; }
+
+    // Renders a frame of the selected effect (or its fallback) and measures it.
+    // Returns the time the frame took in µs.
+    uint32_t renderFrame(uint32_t timeMs);
+
+    bool degraded(int idx) const { return _slots[idx].degraded; }
+    const EffectStats& stats(int idx) const { return _slots[idx].stats; }
+    const EffectStats& fallbackStats(int idx) const { return _slots[idx].fallbackStats; }
+
+    void setBudget(uint32_t budgetUs) { _budgetUs = budgetUs; }
+    uint32_t budget() const { return _budgetUs; }
+
+private:
+    struct Slot {
+        Effect* effect;
+        Effect* fallback;
+        EffectStats stats;
+        EffectStats fallbackStats;
+        int overruns;
+        bool degraded;
+    };
+
+    LedSpan<Rgb> _target;
+    uint32_t _budgetUs;
+    Clock _clock;
+    int _count;
+    int _current;
+    Slot _slots[MAX_EFFECTS];
+};
+
+// Renders frames of the effect into memory at a fixed frame period, without any strip,
+// e.g. on the PC. The time passed to the effect is frame * frameMs, so the output is
+// deterministic. If recording is not null, it receives frames * leds.size() pixels.
+EffectStats runEffect(Effect& effect, LedSpan<Rgb> leds, int frames, uint32_t frameMs, Rgb* recording = nullptr,
+    EffectEngine::Clock clock = detail::timerMicros);
@@ -0,0 +1,143 @@
+#pragma once
+
+// Fixed-point math for animations, for chips without FPU (ESP32-C3) and for hot loops
+// over whole strips. Angles are a full turn in 256 (8-bit) or 65536 (16-bit) steps,
+// fractions are 0..255 (or 0..65535) for 0..1. The tables are built at compile time.
+
+#include <cstdint>
+
+#include "Color.h"
+
+namespace detail {
+
+// Not PI, Arduino.h defines that as a macro
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series, precise to ~1e-12 on [-pi, pi], good enough to fill tables
+constexpr double constexprSin(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 15; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+struct Sin8Table {
+    uint8_t values[256];
+
+    constexpr Sin8Table()
+        : values() {
+        for (int i = 0; i != 256; i++) {
+            double x = i < 128 ? 2 * kPi * i / 256 : 2 * kPi * (i - 256) / 256;
+            int v = int(127.5 + 127.5 * constexprSin(x) + 0.5);
+            values[i] = v > 255 ? 255 : v;
+        }
+    }
+};
+
+// sin(0..pi/2) in 256 steps, scaled to 32767
+struct Sin16QuarterTable {
+    uint16_t values[257];
+
+    constexpr Sin16QuarterTable()
+        : values() {
+        for (int i = 0; i != 257; i++)
+            values[i] = uint16_t(32767 * constexprSin(kPi / 2 * i / 256) + 0.5);
+    }
+};
+
+inline constexpr Sin8Table SIN8_TABLE {};
+inline constexpr Sin16QuarterTable SIN16_TABLE {};
+
+} // namespace detail
+
+// The helpers are named after their FastLED counterparts, the namespace keeps them apart
+// when a sketch uses both libraries
+namespace smartleds {
+
+// 0..255, 128 at theta == 0
+inline uint8_t sin8(uint8_t theta) { return detail::SIN8_TABLE.values[theta]; }
+inline uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+// -32767..32767, linear interpolation between 1024 points per turn
+inline int16_t sin16(uint16_t theta) {
+    uint16_t p = theta & 0x3FFF;
+    if (theta & 0x4000)
+        p = 0x4000 - p;
+    const int idx = p >> 6, frac = p & 0x3F;
+    int v = detail::SIN16_TABLE.values[idx];
+    if (frac)
+        v += ((detail::SIN16_TABLE.values[idx + 1] - v) * frac + 32) >> 6;
+    return theta & 0x8000 ? -v : v;
+}
+inline int16_t cos16(uint16_t theta) { return sin16(theta + 16384); }
+
+// 0 -> 255 -> 0 over a turn
+inline uint8_t tri8(uint8_t theta) { return theta < 128 ? theta << 1 : 511 - (theta << 1); }
+
+// i * scale / 256, except that scale 255 keeps i
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return (uint16_t(i) * (1 + scale)) >> 8; }
+inline uint16_t scale16(uint16_t i, uint16_t scale) { return (uint32_t(i) * (1 + scale)) >> 16; }
+
+// a at frac 0, b at frac 255 (65535)
+inline uint8_t lerp8(uint8_t a, uint8_t b, uint8_t frac) {
+    return a + ((int(b) - a) * (frac + (frac >> 7))) / 256;
+}
+inline uint16_t lerp16(uint16_t a, uint16_t b, uint16_t frac) {
+    return a + (int64_t(int(b) - a) * (frac + (frac >> 15))) / 65536;
+}
+
+inline Rgb lerp(const Rgb& a, const Rgb& b, uint8_t frac) {
+    return Rgb(lerp8(a.r, b.r, frac), lerp8(a.g, b.g, frac), lerp8(a.b, b.b, frac), a.a);
+}
+
+inline Rgb scale8(const Rgb& c, uint8_t scale) { return Rgb(scale8(c.r, scale), scale8(c.g, scale), scale8(c.b, scale), c.a); }
+
+// Scales the whole Rgb strip (SmartLed, Canvas, LedSpan<Rgb>) by scale / 256
+template <class Strip>
+void nscale8(Strip& strip, uint8_t scale) {
+    const uint16_t s = 1 + scale;
+    for (auto& c : strip) {
+        Rgb& p = c;
+        p.r = (p.r * s) >> 8;
+        p.g = (p.g * s) >> 8;
+        p.b = (p.b * s) >> 8;
+    }
+}
+
+template <class Strip>
+void fadeToBlack(Strip& strip, uint8_t amount) {
+    nscale8(strip, 255 - amount);
+}
+
+// Easing curves, 0 -> 0 and 255 -> 255
+inline uint8_t ease8InQuad(uint8_t i) { return scale8(i, i); }
+inline uint8_t ease8OutQuad(uint8_t i) { return 255 - ease8InQuad(255 - i); }
+
+inline uint8_t ease8InOutQuad(uint8_t i) {
+    const uint8_t j = i < 128 ? i : 255 - i;
+    const uint8_t jj = scale8(j, j) << 1;
+    return i < 128 ? jj : 255 - jj;
+}
+
+// 3x^2 - 2x^3 (smoothstep), i.e. i^2 * (3 * 255 - 2i) / 255^2, where 1 / 255^2 ~ 258 / 2^24
+inline uint8_t ease8InOutCubic(uint8_t i) {
+    return (uint32_t(i) * i * (765 - 2 * i) * 258 + (1 << 23)) >> 24;
+}
+
+// Sawtooth of the given beats per minute, one beat is a full 16-bit (8-bit) turn
+inline uint16_t beat16(uint16_t bpm, uint32_t timeMs) { return (uint64_t(timeMs) * bpm * 65536) / 60000; }
+inline uint8_t beat8(uint16_t bpm, uint32_t timeMs) { return beat16(bpm, timeMs) >> 8; }
+
+// Sine wave between low and high of the given beats per minute
+inline uint8_t beatsin8(uint16_t bpm, uint8_t low, uint8_t high, uint32_t timeMs, uint8_t phase = 0) {
+    return low + scale8(sin8(beat8(bpm, timeMs) + phase), high - low);
+}
+
+inline uint16_t beatsin16(uint16_t bpm, uint16_t low, uint16_t high, uint32_t timeMs, uint16_t phase = 0) {
+    const uint16_t wave = sin16(beat16(bpm, timeMs) + phase) + 32768;
+    return low + scale16(wave, high - low);
+}
+
+} // namespace smartleds
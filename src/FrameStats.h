@@ -0,0 +1,111 @@
+#pragma once
+
+// Statistics of an Rgb frame kept up to date as pixels are written, so that application
+// checks like auto brightness or "is it black?" don't have to scan the frame. Writes must
+// go through TrackedPixel (e.g. SmartLed::tracked()), a plain write makes the stats stale
+// until the next scan(). The library itself doesn't read them, the power limit and frame
+// skipping of SmartLed always look at the frame being sent.
+
+#include <cstdint>
+
+#include "Color.h"
+#include "Power.h"
+
+class FrameStats {
+public:
+    // Histogram of the brightest channel of each pixel
+    static constexpr const int BUCKETS = 16;
+
+    FrameStats() { clear(); }
+
+    void clear() {
+        _r = _g = _b = 0;
+        _lit = 0;
+        _count = 0;
+        for (auto& h : _histogram)
+            h = 0;
+    }
+
+    // Recomputes the stats from the frame
+    void scan(const Rgb* pixels, int count) {
+        clear();
+        _count = count;
+        for (int i = 0; i != count; i++)
+            add(pixels[i]);
+    }
+
+    // The pixel changes from old to now
+    void update(const Rgb& old, const Rgb& now) {
+        remove(old);
+        add(now);
+    }
+
+    ChannelSums sums() const { return { _r, _g, _b, _count }; }
+    int count() const { return _count; }
+    // Pixels with any channel non-zero
+    int lit() const { return _lit; }
+    bool black() const { return _lit == 0; }
+    uint32_t histogram(int bucket) const { return _histogram[bucket]; }
+
+    // Upper bound of the brightest channel in the frame, exact to a bucket (16 levels)
+    uint8_t maxLevel() const {
+        for (int i = BUCKETS - 1; i > 0; i--)
+            if (_histogram[i])
+                return i * (256 / BUCKETS) + (256 / BUCKETS - 1);
+        return _lit ? 256 / BUCKETS - 1 : 0;
+    }
+
+private:
+    static int bucket(const Rgb& c) {
+        uint8_t m = c.r > c.g ? c.r : c.g;
+        m = m > c.b ? m : c.b;
+        return m / (256 / BUCKETS);
+    }
+
+    static bool isLit(const Rgb& c) { return c.r | c.g | c.b; }
+
+    void add(const Rgb& c) {
+        _r += c.r;
+        _g += c.g;
+        _b += c.b;
+        _lit += isLit(c);
+        _histogram[bucket(c)]++;
+    }
+
+    void remove(const Rgb& c) {
+        _r -= c.r;
+        _g -= c.g;
+        _b -= c.b;
+        _lit -= isLit(c);
+        _histogram[bucket(c)]--;
+    }
+
+    uint32_t _r, _g, _b;
+    int _lit;
+    int _count;
+    uint32_t _histogram[BUCKETS];
+};
+
+// Reference to a pixel which updates the frame stats on every write
+class TrackedPixel {
+public:
+    TrackedPixel(Rgb& pixel, FrameStats& stats)
+        : _pixel(pixel)
+        , _stats(stats) {}
+
+    TrackedPixel& operator=(const Rgb& c) {
+        _stats.update(_pixel, c);
+        _pixel = c;
+        return *this;
+    }
+    TrackedPixel& operator=(const Hsv& c) { return *this = Rgb(c); }
+    TrackedPixel& operator=(const TrackedPixel& o) { return *this = Rgb(o._pixel); }
+    TrackedPixel& operator+=(const Rgb& c) { return *this = _pixel + c; }
+    TrackedPixel& operator-=(const Rgb& c) { return *this = _pixel - c; }
+
+    operator const Rgb&() const { return _pixel; }
+
+private:
+    Rgb& _pixel;
+    FrameStats& _stats;
+};
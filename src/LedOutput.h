@@ -0,0 +1,78 @@
+#pragma once
+
+// Common interface of the strip drivers (SmartLed, Apa102, LDP8806):
+//
+//   int size() const;                 number of pixels
+//   Pixel& operator[](int idx);       pixel in the front buffer
+//   Pixel* begin(); Pixel* end();     the front buffer as a range
+//   esp_err_t show();                 start sending the front buffer
+//   ShowToken showAsync();            show() returning a completion token
+//   bool wait(TickType_t timeout);    wait for the previous show()
+//   bool ready();                     true if the previous show() is done, never blocks
+//
+// Each driver keeps its native pixel type, all of them are assignable from Rgb. Code
+// templated on the strip type (or taking a LedSpan) works with any of them.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+// Non-owning view of a run of pixels, e.g. a part of a strip's buffer
+template <class Pixel>
+class LedSpan {
+public:
+    LedSpan()
+        : _data(nullptr)
+        , _size(0) {}
+
+    LedSpan(Pixel* data, int size)
+        : _data(data)
+        , _size(size) {}
+
+    int size() const { return _size; }
+    Pixel* data() const { return _data; }
+
+    Pixel& operator[](int idx) const { return _data[idx]; }
+
+    Pixel* begin() const { return _data; }
+    Pixel* end() const { return _data + _size; }
+
+    LedSpan subspan(int offset, int count) const { return LedSpan(_data + offset, count); }
+
+private:
+    Pixel* _data;
+    int _size;
+};
+
+template <class Strip, class = void>
+struct IsLedOutput : std::false_type {};
+
+template <class Strip>
+struct IsLedOutput<Strip,
+    std::void_t<decltype(std::declval<Strip&>().size()), decltype(std::declval<Strip&>()[0]),
+        decltype(std::declval<Strip&>().show()), decltype(std::declval<Strip&>().wait(TickType_t(0))),
+        decltype(std::declval<Strip&>().ready())>> : std::true_type {};
+
+// Front buffer of the strip as a span
+template <class Strip>
+auto ledSpan(Strip& strip) {
+    return LedSpan<std::remove_reference_t<decltype(strip[0])>>(&strip[0], strip.size());
+}
+
+// Starts all the strips first, so they transmit in parallel, then waits for all of them.
+// Returns the first error.
+template <class... Strips>
+esp_err_t showAll(Strips&... strips) {
+    static_assert((IsLedOutput<Strips>::value && ...), "showAll() takes LED strips");
+    esp_err_t err = ESP_OK;
+    auto keep = [&err](esp_err_t e) {
+        if (err == ESP_OK)
+            err = e;
+    };
+    (keep(strips.show()), ...);
+    (strips.wait(portMAX_DELAY), ...);
+    return err;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// Mapping of 2D coordinates onto strips wired as LED matrices.
+//
+// The physical matrix is width x height pixels, optionally tiled from equal panels
+// chained row by row. Inside a panel the strip runs row by row, serpentine panels turn
+// around at the end of every row. The logical (drawing) coordinates can be rotated
+// against the physical ones. MatrixMap precomputes the mapping into lookup tables, so
+// a pixel write is a single table read and remap() converts a whole row-major
+// framebuffer into strip order in one pass.
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+#include "Color.h"
+
+enum MatrixRotation { Rotate0 = 0, Rotate90, Rotate180, Rotate270 };
+
+struct MatrixLayout {
+    int width; // physical size in pixels
+    int height;
+    bool serpentine = true; // every other row of a panel runs the opposite way
+    int panelWidth = 0; // 0 means a single panel over the whole matrix
+    int panelHeight = 0;
+    bool serpentinePanels = false; // every other row of panels runs the opposite way
+    MatrixRotation rotation = Rotate0; // clockwise, from physical to logical coordinates
+
+    bool rotated() const { return rotation == Rotate90 || rotation == Rotate270; }
+    int logicalWidth() const { return rotated() ? height : width; }
+    int logicalHeight() const { return rotated() ? width : height; }
+
+    // The panels must tile the matrix exactly, and it must fit the 16-bit tables of MatrixMap
+    bool valid() const {
+        const int pw = panelWidth > 0 ? panelWidth : width;
+        const int ph = panelHeight > 0 ? panelHeight : height;
+        return width > 0 && height > 0 && width % pw == 0 && height % ph == 0 && width * height <= 65536;
+    }
+
+    // Strip index of the logical pixel, computed without any table
+    int index(int x, int y) const {
+        int px = x, py = y;
+        switch (rotation) {
+        case Rotate0:
+            break;
+        case Rotate90:
+            px = y;
+            py = height - 1 - x;
+            break;
+        case Rotate180:
+            px = width - 1 - x;
+            py = height - 1 - y;
+            break;
+        case Rotate270:
+            px = width - 1 - y;
+            py = x;
+            break;
+        }
+
+        const int pw = panelWidth > 0 ? panelWidth : width;
+        const int ph = panelHeight > 0 ? panelHeight : height;
+        int tx = px / pw, lx = px % pw;
+        const int ty = py / ph, ly = py % ph;
+        if (serpentinePanels && (ty & 1))
+            tx = width / pw - 1 - tx;
+        if (serpentine && (ly & 1))
+            lx = pw - 1 - lx;
+        return (ty * (width / pw) + tx) * pw * ph + ly * pw + lx;
+    }
+};
+
+class MatrixMap {
+public:
+    // The layout must be valid(), the tables are 16-bit
+    MatrixMap(const MatrixLayout& layout)
+        : _layout(layout)
+        , _width(layout.logicalWidth())
+        , _height(layout.logicalHeight())
+        , _index(new uint16_t[layout.width * layout.height])
+        , _order(new uint16_t[layout.width * layout.height]) {
+        assert(layout.valid());
+        for (int y = 0; y != _height; y++) {
+            for (int x = 0; x != _width; x++) {
+                const int idx = layout.index(x, y);
+                _index[y * _width + x] = idx;
+                _order[idx] = y * _width + x;
+            }
+        }
+    }
+
+    // Logical size, i.e. after rotation
+    int width() const { return _width; }
+    int height() const { return _height; }
+    int size() const { return _width * _height; }
+    const MatrixLayout& layout() const { return _layout; }
+
+    // Strip index of the logical pixel
+    int operator()(int x, int y) const { return _index[y * _width + x]; }
+
+    // Row-major framebuffer offset of every strip pixel, in strip order
+    const uint16_t* order() const { return _order.get(); }
+
+    // Writes a row-major framebuffer (width() x height()) into the strip. Reads are
+    // scattered, writes are sequential, which is the cheaper way for the DMA buffers.
+    template <class Strip>
+    void remap(const Rgb* frame, Strip& strip) const {
+        auto* dest = &strip[0];
+        const int count = size();
+        for (int i = 0; i != count; i++)
+            dest[i] = frame[_order[i]];
+    }
+
+private:
+    MatrixLayout _layout;
+    int _width;
+    int _height;
+    std::unique_ptr<uint16_t[]> _index;
+    std::unique_ptr<uint16_t[]> _order;
+};
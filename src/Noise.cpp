@@ -0,0 +1,176 @@
+#include "Noise.h"
+
+namespace {
+
+// Ken Perlin's reference permutation
+const uint8_t PERM[256] = { 151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30,
+    69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11,
+    32, 57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
+    77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54, 65,
+    25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196, 135, 130, 116, 188, 159, 86, 164, 100,
+    109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59,
+    227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155,
+    167, 43, 172, 9, 129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228, 251,
+    34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181,
+    199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93, 222, 114, 67, 29, 24, 72,
+    243, 141, 128, 195, 78, 66, 215, 61, 156, 180 };
+
+// Fractions inside a cell are kept in 12 bits, so that all the products fit into 32 bits
+const int ONE = 4096;
+// Scale of the result into 0..65535, the 3D noise stays within about +-0.9 of a cell
+const int OUTPUT_SCALE = 9;
+
+inline uint8_t perm(int i) { return PERM[i & 0xFF]; }
+
+// 6t^5 - 15t^4 + 10t^3 in 16 bits
+inline int fade(uint16_t t) {
+    const uint32_t t2 = (uint32_t(t) * t) >> 16;
+    const uint32_t t3 = (t2 * t) >> 16;
+    // 6t^2 - 15t + 10 in 12-bit fractions, it's positive on 0..1
+    const int32_t poly = ((6 * int32_t(t2) - 15 * int32_t(t)) >> 4) + (10 << 12);
+    return (t3 * uint32_t(poly)) >> 12;
+}
+
+inline int lerp(int f, int a, int b) { return a + (((b - a) * f) >> 16); }
+
+inline int grad(uint8_t hash, int x, int y, int z) {
+    const int h = hash & 15;
+    const int u = h < 8 ? x : y;
+    const int v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+inline uint16_t toOutput(int n) {
+    int v = 32768 + n * OUTPUT_SCALE;
+    return v < 0 ? 0 : (v > 65535 ? 65535 : v);
+}
+
+// Hashes of the 8 corners of a cell, in the order of the reference implementation
+struct Corners {
+    uint8_t aa, ba, ab, bb, aa1, ba1, ab1, bb1;
+
+    Corners(int X, int Y, int Z) {
+        const int A = perm(X) + Y, AA = perm(A) + Z, AB = perm(A + 1) + Z;
+        const int B = perm(X + 1) + Y, BA = perm(B) + Z, BB = perm(B + 1) + Z;
+        aa = perm(AA);
+        ba = perm(BA);
+        ab = perm(AB);
+        bb = perm(BB);
+        aa1 = perm(AA + 1);
+        ba1 = perm(BA + 1);
+        ab1 = perm(AB + 1);
+        bb1 = perm(BB + 1);
+    }
+};
+
+// Position inside a cell along one axis
+struct Axis {
+    int cell;
+    int f0; // distance from the lower lattice point, 0..ONE
+    int f1; // f0 - ONE
+    int fade;
+
+    Axis(uint32_t v)
+        : cell((v >> 16) & 0xFF)
+        , f0((v & 0xFFFF) >> 4)
+        , f1(f0 - ONE)
+        , fade(::fade(v & 0xFFFF)) {}
+};
+
+inline int noise3(const Corners& c, const Axis& x, const Axis& y, const Axis& z) {
+    const int z0 = lerp(x.fade, grad(c.aa, x.f0, y.f0, z.f0), grad(c.ba, x.f1, y.f0, z.f0));
+    const int z1 = lerp(x.fade, grad(c.ab, x.f0, y.f1, z.f0), grad(c.bb, x.f1, y.f1, z.f0));
+    const int z2 = lerp(x.fade, grad(c.aa1, x.f0, y.f0, z.f1), grad(c.ba1, x.f1, y.f0, z.f1));
+    const int z3 = lerp(x.fade, grad(c.ab1, x.f0, y.f1, z.f1), grad(c.bb1, x.f1, y.f1, z.f1));
+    return lerp(z.fade, lerp(y.fade, z0, z1), lerp(y.fade, z2, z3));
+}
+
+// The z == 0 slice of the 3D noise, only the 4 corners at z == 0 matter
+inline int noise2(const Corners& c, const Axis& x, const Axis& y) {
+    const int y0 = lerp(x.fade, grad(c.aa, x.f0, y.f0, 0), grad(c.ba, x.f1, y.f0, 0));
+    const int y1 = lerp(x.fade, grad(c.ab, x.f0, y.f1, 0), grad(c.bb, x.f1, y.f1, 0));
+    return lerp(y.fade, y0, y1);
+}
+
+// Gradient of one corner along a row, where y and z are constant: sx * x + c
+struct RowGrad {
+    int sx;
+    int c;
+
+    RowGrad() = default;
+    RowGrad(uint8_t hash, int y, int z)
+        : sx(grad(hash, 1, 0, 0))
+        , c(grad(hash, 0, y, z)) {}
+
+    int operator()(int x) const { return sx * x + c; }
+};
+
+// The 8 corner gradients of the cell, for the y and z of the row
+struct RowCell {
+    RowGrad aa, ba, ab, bb, aa1, ba1, ab1, bb1;
+
+    RowCell(const Corners& c, const Axis& y, const Axis& z)
+        : aa(c.aa, y.f0, z.f0)
+        , ba(c.ba, y.f0, z.f0)
+        , ab(c.ab, y.f1, z.f0)
+        , bb(c.bb, y.f1, z.f0)
+        , aa1(c.aa1, y.f0, z.f1)
+        , ba1(c.ba1, y.f0, z.f1)
+        , ab1(c.ab1, y.f1, z.f1)
+        , bb1(c.bb1, y.f1, z.f1) {}
+
+    int noise3(const Axis& x, const Axis& y, const Axis& z) const {
+        const int z0 = lerp(x.fade, aa(x.f0), ba(x.f1));
+        const int z1 = lerp(x.fade, ab(x.f0), bb(x.f1));
+        const int z2 = lerp(x.fade, aa1(x.f0), ba1(x.f1));
+        const int z3 = lerp(x.fade, ab1(x.f0), bb1(x.f1));
+        return lerp(z.fade, lerp(y.fade, z0, z1), lerp(y.fade, z2, z3));
+    }
+
+    int noise2(const Axis& x, const Axis& y) const {
+        const int y0 = lerp(x.fade, aa(x.f0), ba(x.f1));
+        const int y1 = lerp(x.fade, ab(x.f0), bb(x.f1));
+        return lerp(y.fade, y0, y1);
+    }
+};
+
+} // namespace
+
+// The 2D noise has smaller range than the 3D one, it's scaled up by 3/2
+uint16_t noise16(uint32_t x, uint32_t y) {
+    const Axis ax(x), ay(y);
+    return toOutput(noise2(Corners(ax.cell, ay.cell, 0), ax, ay) * 3 / 2);
+}
+
+uint16_t noise16(uint32_t x, uint32_t y, uint32_t z) {
+    const Axis ax(x), ay(y), az(z);
+    return toOutput(noise3(Corners(ax.cell, ay.cell, az.cell), ax, ay, az));
+}
+
+void noiseRow16(uint16_t* dest, int count, uint32_t x, uint32_t stepX, uint32_t y) {
+    const Axis ay(y), az(0);
+    int cell = -1;
+    RowCell grads(Corners(0, 0, 0), ay, az);
+    for (int i = 0; i != count; i++, x += stepX) {
+        const Axis ax(x);
+        if (ax.cell != cell) {
+            cell = ax.cell;
+            grads = RowCell(Corners(cell, ay.cell, 0), ay, az);
+        }
+        dest[i] = toOutput(grads.noise2(ax, ay) * 3 / 2);
+    }
+}
+
+void noiseRow16(uint16_t* dest, int count, uint32_t x, uint32_t stepX, uint32_t y, uint32_t z) {
+    const Axis ay(y), az(z);
+    int cell = -1;
+    RowCell grads(Corners(0, 0, 0), ay, az);
+    for (int i = 0; i != count; i++, x += stepX) {
+        const Axis ax(x);
+        if (ax.cell != cell) {
+            cell = ax.cell;
+            grads = RowCell(Corners(cell, ay.cell, az.cell), ay, az);
+        }
+        dest[i] = toOutput(grads.noise3(ax, ay, az));
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Integer Perlin ("improved noise") gradient noise for organic effects. Coordinates are
+// 16.16 fixed point, i.e. 65536 is one noise cell, the lattice repeats every 256 cells.
+// Uses only integer math, so it gives the same results on every chip and on the PC.
+//
+// The row functions evaluate many samples along x at once and reuse the lattice hashes
+// while the samples stay in the same cell, which is most of the time for the small steps
+// used on strips.
+
+#include <cstdint>
+
+#include "Palette.h"
+
+// 0..65535, 32768 on the lattice points
+uint16_t noise16(uint32_t x, uint32_t y);
+uint16_t noise16(uint32_t x, uint32_t y, uint32_t z);
+
+inline uint8_t noise8(uint32_t x, uint32_t y) { return noise16(x, y) >> 8; }
+inline uint8_t noise8(uint32_t x, uint32_t y, uint32_t z) { return noise16(x, y, z) >> 8; }
+
+// dest[i] = noise16(x + i * stepX, y[, z])
+void noiseRow16(uint16_t* dest, int count, uint32_t x, uint32_t stepX, uint32_t y);
+void noiseRow16(uint16_t* dest, int count, uint32_t x, uint32_t stepX, uint32_t y, uint32_t z);
+
+// Fills the strip with the palette colors picked by the noise along x, e.g. for fire or
+// clouds animated by moving z (or y) every frame
+template <class Strip>
+void fillNoise(Strip& strip, const Palette& palette, uint32_t x, uint32_t stepX, uint32_t y, uint32_t z) {
+    constexpr int CHUNK = 32;
+    uint16_t values[CHUNK];
+    auto* pixels = &strip[0];
+    const int count = strip.size();
+    for (int i = 0; i < count; i += CHUNK) {
+        const int n = count - i < CHUNK ? count - i : CHUNK;
+        noiseRow16(values, n, x + i * stepX, stepX, y, z);
+        for (int j = 0; j != n; j++)
+            pixels[i + j] = palette[values[j] >> 8];
+    }
+}
@@ -0,0 +1,56 @@
+#include "Palette.h"
+
+namespace {
+
+// a + (b - a) * num / den, rounded
+int lerp(int a, int b, int num, int den) {
+    int diff = (b - a) * num;
+    return a + (diff + (diff < 0 ? -den / 2 : den / 2)) / den;
+}
+
+// Calls fill(idx, from, to, num, den) for every palette index, from and to are
+// the stops around it
+template <class Stop, class Fill>
+void interpolate(const Stop* stops, int count, Fill fill) {
+    if (count == 0)
+        return;
+    int next = 0;
+    for (int i = 0; i != Palette::SIZE; i++) {
+        while (next != count && stops[next].position < i)
+            next++;
+        const Stop& to = stops[next == count ? count - 1 : next];
+        const Stop& from = stops[next == 0 ? 0 : next - 1];
+        if (to.position == from.position || to.position <= i)
+            fill(i, to, to, 0, 1);
+        else
+            fill(i, from, to, i - from.position, to.position - from.position);
+    }
+}
+
+} // namespace
+
+Palette Palette::rgb(const PaletteStop<Rgb>* stops, int count) {
+    Palette ret;
+    interpolate(stops, count, [&](int idx, const PaletteStop<Rgb>& from, const PaletteStop<Rgb>& to, int num, int den) {
+        const Rgb& a = from.color;
+        const Rgb& b = to.color;
+        ret._colors[idx] = Rgb(lerp(a.r, b.r, num, den), lerp(a.g, b.g, num, den), lerp(a.b, b.b, num, den));
+    });
+    return ret;
+}
+
+Palette Palette::hsv(const PaletteStop<Hsv>* stops, int count) {
+    Palette ret;
+    interpolate(stops, count, [&](int idx, const PaletteStop<Hsv>& from, const PaletteStop<Hsv>& to, int num, int den) {
+        const Hsv& a = from.color;
+        const Hsv& b = to.color;
+        int hueDiff = b.h - a.h;
+        if (hueDiff > 128)
+            hueDiff -= 256;
+        else if (hueDiff < -128)
+            hueDiff += 256;
+        const uint8_t h = lerp(a.h, a.h + hueDiff, num, den);
+        ret._colors[idx] = Hsv(h, lerp(a.s, b.s, num, den), lerp(a.v, b.v, num, den));
+    });
+    return ret;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <initializer_list>
+
+#include "Color.h"
+
+template <class Color>
+struct PaletteStop {
+    uint8_t position;
+    Color color;
+};
+
+// 256 colors precomputed from a gradient, so that "index into a gradient" effects cost
+// a table lookup per pixel instead of a HSV -> RGB conversion. Takes 1 kB of RAM.
+class Palette {
+public:
+    static constexpr const int SIZE = 256;
+
+    // All black
+    Palette() {}
+
+    // The stops must be sorted by position. The colors before the first and after
+    // the last stop are the colors of those stops.
+    //
+    // Interpolates the channels of the RGB stops
+    static Palette rgb(std::initializer_list<PaletteStop<Rgb>> stops) { return rgb(stops.begin(), stops.size()); }
+    static Palette rgb(const PaletteStop<Rgb>* stops, int count);
+
+    // Interpolates hue (the shorter way around), saturation and value, then converts
+    // the result to RGB
+    static Palette hsv(std::initializer_list<PaletteStop<Hsv>> stops) { return hsv(stops.begin(), stops.size()); }
+    static Palette hsv(const PaletteStop<Hsv>* stops, int count);
+
+    const Rgb& operator[](uint8_t idx) const { return _colors[idx]; }
+    Rgb& operator[](uint8_t idx) { return _colors[idx]; }
+
+private:
+    Rgb _colors[SIZE];
+};
+
+// Sets pixel i of the strip to palette[startIndex + i * step], the index wraps around.
+// Works with any strip type, e.g. SmartLed, Apa102 or LedSpan.
+template <class Strip>
+void fillFromPalette(Strip& strip, const Palette& palette, uint8_t startIndex, uint8_t step = 1) {
+    auto* pixels = &strip[0];
+    const int count = strip.size();
+    uint8_t idx = startIndex;
+    for (int i = 0; i != count; i++, idx += step)
+        pixels[i] = palette[idx];
+}
+
+// Same as above, with the step in 1/256 of an index, for gradients spanning
+// more pixels than the palette has colors
+template <class Strip>
+void fillFromPaletteFine(Strip& strip, const Palette& palette, uint16_t startIndex, uint16_t step) {
+    auto* pixels = &strip[0];
+    const int count = strip.size();
+    uint16_t idx = startIndex;
+    for (int i = 0; i != count; i++, idx += step)
+        pixels[i] = palette[idx >> 8];
+}
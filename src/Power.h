@@ -0,0 +1,92 @@
+#pragma once
+
+// Current estimation and limiting. A PowerModel gives the current of one LED per channel
+// at full scale, plus its idle current; the estimate is linear in the channel values,
+// which is how the constant current drivers of the LEDs behave.
+
+#include <cstdint>
+
+#include "Color.h"
+#include "FixedMath.h"
+
+struct PowerModel {
+    uint16_t redMa;
+    uint16_t greenMa;
+    uint16_t blueMa;
+    // Draw of one LED which is off, in µA
+    uint16_t idleUa;
+};
+
+// Datasheet values, measure your strip if you need them exact
+static const PowerModel POWER_WS2812 = { 20, 20, 20, 1000 };
+static const PowerModel POWER_WS2812B = { 13, 13, 13, 1000 };
+static const PowerModel POWER_SK6812 = { 16, 16, 16, 1000 };
+static const PowerModel POWER_WS2813 = { 15, 15, 15, 800 };
+
+struct ChannelSums {
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+    int count;
+};
+
+// Sums the channels of the pixels in a single pass, two channels per addition
+inline ChannelSums channelSums(const Rgb* pixels, int count) {
+    ChannelSums ret = { 0, 0, 0, count };
+    for (int start = 0; start < count; start += 256) {
+        // 16-bit lanes can't overflow within 256 pixels
+        const int end = count - start < 256 ? count : start + 256;
+        uint32_t gb = 0, ra = 0;
+        for (int i = start; i != end; i++) {
+            const uint32_t v = pixels[i].value;
+            gb += v & 0x00FF00FF;
+            ra += (v >> 8) & 0x00FF00FF;
+        }
+        ret.g += gb & 0xFFFF;
+        ret.b += gb >> 16;
+        ret.r += ra & 0xFFFF;
+    }
+    return ret;
+}
+
+// Current of the lit channels in mA, without the idle current
+inline uint32_t dynamicCurrentMa(const PowerModel& model, const ChannelSums& sums) {
+    const uint64_t scaled = uint64_t(sums.r) * model.redMa + uint64_t(sums.g) * model.greenMa
+        + uint64_t(sums.b) * model.blueMa;
+    return (scaled + 254) / 255;
+}
+
+inline uint32_t idleCurrentMa(const PowerModel& model, int count) {
+    return (uint64_t(count) * model.idleUa + 999) / 1000;
+}
+
+inline uint32_t estimateCurrentMa(const PowerModel& model, const ChannelSums& sums) {
+    return dynamicCurrentMa(model, sums) + idleCurrentMa(model, sums.count);
+}
+
+inline uint32_t estimateCurrentMa(const PowerModel& model, const Rgb* pixels, int count) {
+    return estimateCurrentMa(model, channelSums(pixels, count));
+}
+
+// Brightness for scale8 which keeps the frame at or under budgetMa, 255 when it fits
+inline uint8_t powerScale(const PowerModel& model, const ChannelSums& sums, uint32_t budgetMa) {
+    const uint32_t dynamic = dynamicCurrentMa(model, sums);
+    const uint32_t idle = idleCurrentMa(model, sums.count);
+    if (dynamic + idle <= budgetMa)
+        return 255;
+    if (budgetMa <= idle)
+        return 0;
+    // scale8 multiplies by (scale + 1) / 256
+    const uint32_t s = uint64_t(budgetMa - idle) * 256 / dynamic;
+    return s == 0 ? 0 : s - 1;
+}
+
+// Scales the strip in place to fit the budget, for strips without a limit in the driver
+// (SmartLed::setPowerLimit() does it while encoding). Returns the scale used.
+template <class Strip>
+uint8_t limitPower(Strip& strip, const PowerModel& model, uint32_t budgetMa) {
+    const uint8_t scale = powerScale(model, channelSums(&strip[0], strip.size()), budgetMa);
+    if (scale != 255)
+        smartleds::nscale8(strip, scale);
+    return scale;
+}
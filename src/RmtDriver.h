@@ -27,6 +27,8 @@ using LedType = TimingParams;
 
 } // namespace detail
 
+#include "RmtStats.h"
+
 #if SMARTLEDS_NEW_RMT_DRIVER
 #include "RmtDriver5.h"
 #else
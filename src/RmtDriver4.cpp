@@ -1,7 +1,9 @@
 #include "RmtDriver4.h"
 
 #if !SMARTLEDS_NEW_RMT_DRIVER
+#include "RmtSymbols.h"
 #include "SmartLeds.h"
+#include <esp_heap_caps.h>
 
 namespace detail {
 
@@ -15,7 +17,12 @@ RmtDriver::RmtDriver(const LedType& timing, int count, int pin, int channel_num,
     , _count(count)
     , _pin((gpio_num_t)pin)
     , _finishedFlag(finishedFlag)
-    , _channel((rmt_channel_t)channel_num) {
+    , _channel((rmt_channel_t)channel_num)
+    , _translatorSourceOffset(0)
+    , _translatorBuffer(nullptr)
+    , _order(nullptr)
+    , _scale(255)
+    , _baked(nullptr) {
     _bitToRmt[0].level0 = 1;
     _bitToRmt[0].level1 = 0;
     _bitToRmt[0].duration0 = _timing.T0H / (RMT_DURATION_NS * DIVIDER);
@@ -25,8 +32,13 @@ RmtDriver::RmtDriver(const LedType& timing, int count, int pin, int channel_num,
     _bitToRmt[1].level1 = 0;
     _bitToRmt[1].duration0 = _timing.T1H / (RMT_DURATION_NS * DIVIDER);
     _bitToRmt[1].duration1 = _timing.T1L / (RMT_DURATION_NS * DIVIDER);
+
+    // The channel uses a single memory block
+    probe().setDrainTime(drainTimeUs(_timing, SOC_RMT_MEM_WORDS_PER_CHANNEL));
 }
 
+RmtDriver::~RmtDriver() { heap_caps_free(_baked); }
+
 esp_err_t RmtDriver::init() {
     rmt_config_t config = RMT_DEFAULT_CONFIG_TX(_pin, _channel);
     config.rmt_mode = RMT_MODE_TX;
@@ -62,23 +74,31 @@ esp_err_t RmtDriver::registerIsr(bool isFirstRegisteredChannel) {
 esp_err_t RmtDriver::unregisterIsr() { return rmt_driver_uninstall(_channel); }
 
 void IRAM_ATTR RmtDriver::txEndCallback(rmt_channel_t channel, void* arg) {
-    xSemaphoreGiveFromISR(SmartLed::ledForChannel(channel)->_finishedFlag, nullptr);
+    auto* led = SmartLed::ledForChannel(channel);
+    led->_driver->probe().frameEnd();
+    xSemaphoreGiveFromISR(led->_finishedFlag, nullptr);
 }
 
 void IRAM_ATTR RmtDriver::translateSample(const void* src, rmt_item32_t* dest, size_t src_size,
     size_t wanted_rmt_items_num, size_t* out_consumed_src_bytes, size_t* out_used_rmt_items) {
     RmtDriver* self;
     ESP_ERROR_CHECK(rmt_translator_get_context(out_used_rmt_items, (void**)&self));
+    const uint32_t probeStart = self->probe().refillStart();
 
     const auto& _bitToRmt = self->_bitToRmt;
     const auto src_offset = self->_translatorSourceOffset;
+    const auto* order = self->_order;
+    const auto scale = self->_scale;
 
     auto* src_components = (const uint8_t*)src;
     size_t consumed_src_bytes = 0;
     size_t used_rmt_items = 0;
 
     while (consumed_src_bytes < src_size && used_rmt_items + 7 < wanted_rmt_items_num) {
-        uint8_t val = *src_components;
+        // With an order, src is only a cursor and the bytes come from the mapped pixel
+        const size_t offset = src_offset + consumed_src_bytes;
+        uint8_t val = order ? ((const uint8_t*)&self->_translatorBuffer[order[offset / 4]])[offset % 4] : *src_components;
+        val = scaleChannel(val, scale);
 
         // each bit, from highest to lowest
         for (uint8_t j = 0; j != 8; j++, val <<= 1) {
@@ -105,13 +125,45 @@ void IRAM_ATTR RmtDriver::translateSample(const void* src, rmt_item32_t* dest, s
     self->_translatorSourceOffset = src_offset + consumed_src_bytes;
     *out_consumed_src_bytes = consumed_src_bytes;
     *out_used_rmt_items = used_rmt_items;
+    self->probe().refillEnd(probeStart);
 }
 
 esp_err_t RmtDriver::transmit(const Rgb* buffer) {
     static_assert(sizeof(Rgb) == 4); // The translator code above assumes RGB is 4 bytes
 
     _translatorSourceOffset = 0;
+    _translatorBuffer = buffer;
+    probe().frameStart();
     return rmt_write_sample(_channel, (const uint8_t*)buffer, _count * 4, false);
 }
+
+esp_err_t RmtDriver::bake(const Rgb* buffer) {
+    static_assert(sizeof(rmt_item32_t) == sizeof(uint32_t));
+    if (_count == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (!_baked) {
+        _baked = (rmt_item32_t*)heap_caps_malloc(sizeof(rmt_item32_t) * _count * SYMBOLS_PER_PIXEL, MALLOC_CAP_INTERNAL);
+        if (!_baked) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    auto* end = (rmt_item32_t*)encodeSymbols(
+        buffer, _order, _count, _scale, _bitToRmt[0].val, _bitToRmt[1].val, (uint32_t*)_baked);
+
+    // TRST delay after last pixel in strip
+    (end - 1)->duration1 = _timing.TRS / (detail::RMT_DURATION_NS * detail::DIVIDER);
+    return ESP_OK;
+}
+
+esp_err_t RmtDriver::transmitBaked() {
+    if (!_baked) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    probe().frameStart();
+    return rmt_write_items(_channel, _baked, _count * SYMBOLS_PER_PIXEL, false);
+}
 };
 #endif // !SMARTLEDS_NEW_RMT_DRIVER
@@ -12,15 +12,24 @@ namespace detail {
 
 constexpr const int CHANNEL_COUNT = RMT_CHANNEL_MAX;
 
-class RmtDriver {
+// The probe is an empty base unless SMARTLEDS_RMT_STATS is set, so it takes no space
+class RmtDriver : private RmtDriverProbe {
 public:
     RmtDriver(const LedType& timing, int count, int pin, int channel_num, SemaphoreHandle_t finishedFlag);
     RmtDriver(const RmtDriver&) = delete;
+    ~RmtDriver();
 
     esp_err_t init();
     esp_err_t registerIsr(bool isFirstRegisteredChannel);
     esp_err_t unregisterIsr();
     esp_err_t transmit(const Rgb* buffer);
+    esp_err_t bake(const Rgb* buffer);
+    esp_err_t transmitBaked();
+    void setOrder(const uint16_t* order) { _order = order; }
+    void setScale(uint8_t scale) { _scale = scale; }
+    RmtStats stats() const { return RmtDriverProbe::stats(); }
+    void resetStats() { RmtDriverProbe::reset(); }
+    RmtDriverProbe& IRAM_ATTR probe() { return *this; }
 
 private:
     static void IRAM_ATTR txEndCallback(rmt_channel_t channel, void* arg);
@@ -36,6 +45,10 @@ private:
     rmt_channel_t _channel;
     rmt_item32_t _bitToRmt[2];
     size_t _translatorSourceOffset;
+    const Rgb* _translatorBuffer;
+    const uint16_t* _order;
+    uint8_t _scale;
+    rmt_item32_t* _baked;
 };
 
 };
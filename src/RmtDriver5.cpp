@@ -2,7 +2,9 @@
 
 #if SMARTLEDS_NEW_RMT_DRIVER
 #include <cstddef>
+#include <esp_heap_caps.h>
 
+#include "RmtSymbols.h"
 #include "SmartLeds.h"
 
 namespace detail {
@@ -10,13 +12,21 @@ namespace detail {
 static constexpr const uint32_t RMT_RESOLUTION_HZ = 20 * 1000 * 1000; // 20 MHz
 static constexpr const uint32_t RMT_NS_PER_TICK = 1000000000LLU / RMT_RESOLUTION_HZ;
 
+static rmt_symbol_word_t symbolFor(uint32_t highNs, uint32_t lowNs) {
+    rmt_symbol_word_t symbol = {};
+    symbol.duration0 = highNs / RMT_NS_PER_TICK;
+    symbol.level0 = 1;
+    symbol.duration1 = lowNs / RMT_NS_PER_TICK;
+    symbol.level1 = 0;
+    return symbol;
+}
+
 static RmtEncoderWrapper* IRAM_ATTR encSelf(rmt_encoder_t* encoder) {
     return (RmtEncoderWrapper*)(((intptr_t)encoder) - offsetof(RmtEncoderWrapper, base));
 }
 
-static size_t IRAM_ATTR encEncode(rmt_encoder_t* encoder, rmt_channel_handle_t tx_channel, const void* primary_data,
-    size_t data_size, rmt_encode_state_t* ret_state) {
-    auto* self = encSelf(encoder);
+static size_t IRAM_ATTR encEncodeSymbols(RmtEncoderWrapper* self, rmt_channel_handle_t tx_channel,
+    const void* primary_data, size_t data_size, rmt_encode_state_t* ret_state) {
 
     // Delay after last pixel
     if ((self->last_state & RMT_ENCODING_COMPLETE) && self->frame_idx == data_size) {
@@ -26,17 +36,18 @@ static size_t IRAM_ATTR encEncode(rmt_encoder_t* encoder, rmt_channel_handle_t t
     }
 
     if (self->last_state & RMT_ENCODING_COMPLETE) {
-        Rgb* pixel = ((Rgb*)primary_data) + self->frame_idx;
+        const Rgb* pixels = (const Rgb*)primary_data;
+        Rgb pixel = emittedPixel(pixels, self->order, self->frame_idx);
         self->buffer_len = sizeof(self->buffer);
         for (size_t i = 0; i < sizeof(self->buffer); ++i) {
-            self->buffer[i] = pixel->getGrb(self->component_idx);
+            self->buffer[i] = scaleChannel(pixel.getGrb(self->component_idx), self->scale);
             if (++self->component_idx == 3) {
                 self->component_idx = 0;
                 if (++self->frame_idx == data_size) {
                     self->buffer_len = i + 1;
                     break;
                 }
-                ++pixel;
+                pixel = emittedPixel(pixels, self->order, self->frame_idx);
             }
         }
     }
@@ -53,6 +64,15 @@ static size_t IRAM_ATTR encEncode(rmt_encoder_t* encoder, rmt_channel_handle_t t
     return encoded_symbols;
 }
 
+static size_t IRAM_ATTR encEncode(rmt_encoder_t* encoder, rmt_channel_handle_t tx_channel, const void* primary_data,
+    size_t data_size, rmt_encode_state_t* ret_state) {
+    auto* self = encSelf(encoder);
+    const uint32_t probeStart = self->driver->probe().refillStart();
+    auto encoded_symbols = encEncodeSymbols(self, tx_channel, primary_data, data_size, ret_state);
+    self->driver->probe().refillEnd(probeStart);
+    return encoded_symbols;
+}
+
 static esp_err_t encReset(rmt_encoder_t* encoder) {
     auto* self = encSelf(encoder);
     rmt_encoder_reset(self->bytes_encoder);
@@ -76,7 +96,14 @@ RmtDriver::RmtDriver(const LedType& timing, int count, int pin, int channel_num,
     , _pin(pin)
     , _finishedFlag(finishedFlag)
     , _channel(nullptr)
-    , _encoder {} {}
+    , _encoder {}
+    , _baked(nullptr) {
+    _encoder.driver = this;
+    _encoder.scale = 255;
+    probe().setDrainTime(drainTimeUs(_timing, SOC_RMT_MEM_WORDS_PER_CHANNEL));
+}
+
+RmtDriver::~RmtDriver() { heap_caps_free(_baked); }
 
 esp_err_t RmtDriver::init() {
     _encoder.base.encode = encEncode;
@@ -162,6 +189,7 @@ esp_err_t RmtDriver::unregisterIsr() {
 bool IRAM_ATTR RmtDriver::txDoneCallback(
     rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t* edata, void* user_ctx) {
     auto* self = (RmtDriver*)user_ctx;
+    self->probe().frameEnd();
     auto taskWoken = pdTRUE;
     xSemaphoreGiveFromISR(self->_finishedFlag, &taskWoken);
     return taskWoken == pdTRUE;
@@ -170,7 +198,40 @@ bool IRAM_ATTR RmtDriver::txDoneCallback(
 esp_err_t RmtDriver::transmit(const Rgb* buffer) {
     rmt_encoder_reset(&_encoder.base);
     rmt_transmit_config_t cfg = {};
+    probe().frameStart();
     return rmt_transmit(_channel, &_encoder.base, buffer, _count, &cfg);
 }
+
+esp_err_t RmtDriver::bake(const Rgb* buffer) {
+    static_assert(sizeof(rmt_symbol_word_t) == sizeof(uint32_t));
+    if (!_baked) {
+        // The copy encoder reads the symbols from the ISR, keep them in internal RAM
+        _baked = (rmt_symbol_word_t*)heap_caps_malloc(
+            sizeof(rmt_symbol_word_t) * (_count * SYMBOLS_PER_PIXEL + 1), MALLOC_CAP_INTERNAL);
+        if (!_baked) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    const auto bit0 = symbolFor(_timing.T0H, _timing.T0L);
+    const auto bit1 = symbolFor(_timing.T1H, _timing.T1L);
+    auto* end = (rmt_symbol_word_t*)encodeSymbols(buffer, _encoder.order, _count, _encoder.scale, bit0.val, bit1.val, (uint32_t*)_baked);
+
+    // Delay after last pixel
+    *end = _encoder.reset_code;
+    return ESP_OK;
+}
+
+esp_err_t RmtDriver::transmitBaked() {
+    if (!_baked) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    rmt_encoder_reset(_encoder.copy_encoder);
+    rmt_transmit_config_t cfg = {};
+    probe().frameStart();
+    return rmt_transmit(_channel, _encoder.copy_encoder, _baked,
+        sizeof(rmt_symbol_word_t) * (_count * SYMBOLS_PER_PIXEL + 1), &cfg);
+}
 };
 #endif // !SMARTLEDS_NEW_RMT_DRIVER
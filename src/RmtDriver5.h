@@ -28,6 +28,8 @@ struct RmtEncoderWrapper {
     struct rmt_encoder_t* copy_encoder;
     RmtDriver* driver;
     rmt_symbol_word_t reset_code;
+    const uint16_t* order;
+    uint8_t scale;
 
     uint8_t buffer[SOC_RMT_MEM_WORDS_PER_CHANNEL / 8];
     rmt_encode_state_t last_state;
@@ -38,15 +40,24 @@ struct RmtEncoderWrapper {
 
 static_assert(std::is_standard_layout<RmtEncoderWrapper>::value == true);
 
-class RmtDriver {
+// The probe is an empty base unless SMARTLEDS_RMT_STATS is set, so it takes no space
+class RmtDriver : private RmtDriverProbe {
 public:
     RmtDriver(const LedType& timing, int count, int pin, int channel_num, SemaphoreHandle_t finishedFlag);
     RmtDriver(const RmtDriver&) = delete;
+    ~RmtDriver();
 
     esp_err_t init();
     esp_err_t registerIsr(bool isFirstRegisteredChannel);
     esp_err_t unregisterIsr();
     esp_err_t transmit(const Rgb* buffer);
+    esp_err_t bake(const Rgb* buffer);
+    esp_err_t transmitBaked();
+    void setOrder(const uint16_t* order) { _encoder.order = order; }
+    void setScale(uint8_t scale) { _encoder.scale = scale; }
+    RmtStats stats() const { return RmtDriverProbe::stats(); }
+    void resetStats() { RmtDriverProbe::reset(); }
+    RmtDriverProbe& IRAM_ATTR probe() { return *this; }
 
 private:
     static bool IRAM_ATTR txDoneCallback(
@@ -59,6 +70,7 @@ private:
 
     rmt_channel_handle_t _channel;
     RmtEncoderWrapper _encoder;
+    rmt_symbol_word_t* _baked;
 };
 
 };
@@ -0,0 +1,136 @@
+#pragma once
+
+// Instrumentation of the RMT drivers, for diagnosing glitching strips. Disabled by default,
+// build with -DSMARTLEDS_RMT_STATS=1 to enable it. When disabled, the probe is an empty
+// class and all its calls are empty inline functions, the drivers don't change.
+
+#include <cstdint>
+
+#include <esp_attr.h>
+#include <esp_cpu.h>
+#include <esp_timer.h>
+
+#ifndef SMARTLEDS_RMT_STATS
+#define SMARTLEDS_RMT_STATS 0
+#endif
+
+// A refill is one call of the encoder (translator), which tops up the RMT memory. Baked
+// frames (showBaked(), refresh) are only counted as frames, the IDF copies their symbols.
+struct RmtStats {
+    uint32_t frames;
+    uint32_t refills;
+    // CPU cycles spent in one refill
+    uint32_t refillCyclesMin;
+    uint32_t refillCyclesMax;
+    uint64_t refillCyclesTotal;
+    // From the transmission start to the TX done interrupt
+    uint32_t lastFrameUs;
+    uint32_t maxFrameUs;
+    // Refills which came later than the RMT memory could last, i.e. the strip saw a gap
+    uint32_t underruns;
+
+    uint32_t refillCyclesAverage() const { return refills ? refillCyclesTotal / refills : 0; }
+};
+
+namespace detail {
+
+inline uint32_t IRAM_ATTR cycleCount() {
+#if SMARTLEDS_NEW_RMT_DRIVER
+    return esp_cpu_get_cycle_count();
+#else
+    return esp_cpu_get_ccount();
+#endif
+}
+
+template <bool Enabled>
+class RmtProbe;
+
+template <>
+class RmtProbe<false> {
+public:
+    void setDrainTime(uint32_t) {}
+    void frameStart() {}
+    uint32_t refillStart() { return 0; }
+    void refillEnd(uint32_t) {}
+    void frameEnd() {}
+
+    RmtStats stats() const { return RmtStats {}; }
+    void reset() {}
+};
+
+// The counters are written from the ISR and read without locking, a read racing with
+// a refill may mix values of two refills.
+template <>
+class RmtProbe<true> {
+public:
+    RmtProbe()
+        : _drainUs(0) {
+        reset();
+    }
+
+    // Airtime of the whole RMT memory of the channel. A refill ending later than this after
+    // the previous one means the memory ran dry. It's a lower bound of underruns: a refill
+    // can also be late when the memory was only half full.
+    void setDrainTime(uint32_t us) { _drainUs = us; }
+
+    void frameStart() {
+        _frameStartUs = esp_timer_get_time();
+        _lastRefillUs = 0;
+    }
+
+    uint32_t IRAM_ATTR refillStart() { return cycleCount(); }
+
+    void IRAM_ATTR refillEnd(uint32_t startCycles) { recordRefill(cycleCount() - startCycles, esp_timer_get_time()); }
+
+    void IRAM_ATTR frameEnd() { recordFrame(esp_timer_get_time() - _frameStartUs); }
+
+    // The parts of the above with explicit times, e.g. for tests
+    void IRAM_ATTR recordRefill(uint32_t cycles, int64_t endUs) {
+        _stats.refills++;
+        _stats.refillCyclesTotal += cycles;
+        if (cycles < _stats.refillCyclesMin)
+            _stats.refillCyclesMin = cycles;
+        if (cycles > _stats.refillCyclesMax)
+            _stats.refillCyclesMax = cycles;
+        if (_lastRefillUs && _drainUs && endUs - _lastRefillUs > _drainUs)
+            _stats.underruns++;
+        _lastRefillUs = endUs;
+    }
+
+    void IRAM_ATTR recordFrame(uint32_t us) {
+        _stats.frames++;
+        _stats.lastFrameUs = us;
+        if (us > _stats.maxFrameUs)
+            _stats.maxFrameUs = us;
+    }
+
+    RmtStats stats() const {
+        RmtStats ret = _stats;
+        if (!ret.refills)
+            ret.refillCyclesMin = 0;
+        return ret;
+    }
+
+    void reset() {
+        _stats = RmtStats {};
+        _stats.refillCyclesMin = UINT32_MAX;
+        _frameStartUs = 0;
+        _lastRefillUs = 0;
+    }
+
+private:
+    RmtStats _stats;
+    uint32_t _drainUs;
+    int64_t _frameStartUs;
+    int64_t _lastRefillUs;
+};
+
+using RmtDriverProbe = RmtProbe<SMARTLEDS_RMT_STATS != 0>;
+
+// Airtime of `symbols` of the slower bit
+inline uint32_t drainTimeUs(const TimingParams& timing, int symbols) {
+    const uint32_t bit0 = timing.T0H + timing.T0L, bit1 = timing.T1H + timing.T1L;
+    return uint64_t(bit0 > bit1 ? bit0 : bit1) * symbols / 1000;
+}
+
+} // namespace detail
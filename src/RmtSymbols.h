@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Color.h"
+
+namespace detail {
+
+// Every pixel is sent as 24 bits (G, R, B), each bit is one RMT symbol
+static constexpr const int SYMBOLS_PER_PIXEL = 24;
+
+// Expands pixels into RMT symbols, MSB first in GRB order. Symbols are passed as raw
+// 32-bit words, which is the layout of both rmt_item32_t (IDF 4) and rmt_symbol_word_t (IDF 5).
+// Returns pointer past the last written symbol.
+inline uint32_t* IRAM_ATTR encodeSymbols(const Rgb* src, size_t count, uint32_t bit0, uint32_t bit1, uint32_t* dest) {
+    const uint32_t bitToSymbol[2] = { bit0, bit1 };
+    for (size_t i = 0; i != count; i++) {
+        const uint8_t grb[3] = { src[i].g, src[i].r, src[i].b };
+        for (uint8_t val : grb) {
+            for (int j = 0; j != 8; j++, val <<= 1) {
+                *dest++ = bitToSymbol[val >> 7];
+            }
+        }
+    }
+    return dest;
+}
+
+// smartleds::scale8 for the encoders, which run from the ISR and must not call into flash
+inline uint8_t IRAM_ATTR scaleChannel(uint8_t value, uint8_t scale) { return (uint16_t(value) * (1 + scale)) >> 8; }
+
+// Pixel sent at position idx of the frame. Without an order the buffer is sent as is,
+// otherwise order[idx] is the buffer index of the idx-th pixel on the wire.
+inline const Rgb& IRAM_ATTR emittedPixel(const Rgb* src, const uint16_t* order, size_t idx) {
+    return src[order ? order[idx] : idx];
+}
+
+// Same as above, but reads the pixels in the given order (see emittedPixel)
+inline uint32_t* IRAM_ATTR encodeSymbols(
+    const Rgb* src, const uint16_t* order, size_t count, uint32_t bit0, uint32_t bit1, uint32_t* dest) {
+    if (!order)
+        return encodeSymbols(src, count, bit0, bit1, dest);
+    const uint32_t bitToSymbol[2] = { bit0, bit1 };
+    for (size_t i = 0; i != count; i++) {
+        const Rgb& pixel = src[order[i]];
+        const uint8_t grb[3] = { pixel.g, pixel.r, pixel.b };
+        for (uint8_t val : grb) {
+            for (int j = 0; j != 8; j++, val <<= 1) {
+                *dest++ = bitToSymbol[val >> 7];
+            }
+        }
+    }
+    return dest;
+}
+
+// Same as above, with every channel scaled by scaleChannel (brightness or power limit), so the
+// scaling costs no extra pass over the buffer
+inline uint32_t* IRAM_ATTR encodeSymbols(const Rgb* src, const uint16_t* order, size_t count, uint8_t scale,
+    uint32_t bit0, uint32_t bit1, uint32_t* dest) {
+    if (scale == 255)
+        return encodeSymbols(src, order, count, bit0, bit1, dest);
+    const uint32_t bitToSymbol[2] = { bit0, bit1 };
+    for (size_t i = 0; i != count; i++) {
+        const Rgb& pixel = emittedPixel(src, order, i);
+        const uint8_t grb[3] = { scaleChannel(pixel.g, scale), scaleChannel(pixel.r, scale), scaleChannel(pixel.b, scale) };
+        for (uint8_t val : grb) {
+            for (int j = 0; j != 8; j++, val <<= 1) {
+                *dest++ = bitToSymbol[val >> 7];
+            }
+        }
+    }
+    return dest;
+}
+
+} // namespace detail
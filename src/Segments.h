@@ -0,0 +1,111 @@
+#pragma once
+
+// Logical sub-strips (zones) of one physical strip.
+//
+// A SegmentRange describes which physical pixels form the zone, Segment is a view
+// through which an effect draws as if the zone was a strip of its own. SegmentMap
+// renders many zones in a single sequential sweep over the strip buffer instead of
+// one pass per zone.
+
+#include <cassert>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+struct SegmentRange {
+    int start; // physical index of the first logical pixel (the last one when reversed)
+    int length;
+    int stride = 1; // physical distance between neighbouring logical pixels
+    bool reversed = false;
+
+    int physical(int idx) const { return start + (reversed ? length - 1 - idx : idx) * stride; }
+};
+
+template <class Pixel>
+class Segment {
+public:
+    Segment(Pixel* base, SegmentRange range)
+        : _base(base)
+        , _range(range) {}
+
+    int size() const { return _range.length; }
+    const SegmentRange& range() const { return _range; }
+
+    Pixel& operator[](int idx) const { return _base[_range.physical(idx)]; }
+
+private:
+    Pixel* _base;
+    SegmentRange _range;
+};
+
+// View of a zone of any strip (SmartLed, Apa102, LDP8806, LedSpan)
+template <class Strip>
+auto segment(Strip& strip, SegmentRange range) {
+    return Segment<std::remove_reference_t<decltype(strip[0])>>(&strip[0], range);
+}
+
+// Precomputed owner of every physical pixel. Where zones overlap, the later one wins.
+class SegmentMap {
+public:
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    SegmentMap(int count, const SegmentRange* ranges, int rangeCount)
+        : _count(count)
+        , _segmentCount(rangeCount)
+        , _entries(new Entry[count])
+        , _ranges(new SegmentRange[rangeCount]) {
+        // The tables are 16-bit, NONE is reserved
+        assert(rangeCount < NONE);
+        for (int i = 0; i != count; i++)
+            _entries[i] = { NONE, 0 };
+        for (int s = 0; s != rangeCount; s++) {
+            const auto& r = _ranges[s] = ranges[s];
+            assert(r.length <= 65536);
+            for (int i = 0; i != r.length; i++) {
+                int p = r.physical(i);
+                if (p >= 0 && p < count)
+                    _entries[p] = { uint16_t(s), uint16_t(i) };
+            }
+        }
+    }
+
+    SegmentMap(int count, std::initializer_list<SegmentRange> ranges)
+        : SegmentMap(count, ranges.begin(), ranges.size()) {}
+
+    int size() const { return _count; }
+    int segmentCount() const { return _segmentCount; }
+    const SegmentRange& range(int segment) const { return _ranges[segment]; }
+
+    uint16_t owner(int physical) const { return _entries[physical].segment; }
+    uint16_t localIndex(int physical) const { return _entries[physical].index; }
+
+    template <class Strip>
+    auto segment(Strip& strip, int idx) const {
+        return ::segment(strip, _ranges[idx]);
+    }
+
+    // Writes every pixel covered by a zone exactly once, in physical order. The
+    // function is called as fn(segment, localIndex) and returns the pixel color.
+    // Pixels outside all zones are left untouched.
+    template <class Strip, class Fn>
+    void render(Strip& strip, Fn&& fn) const {
+        auto* pixels = &strip[0];
+        for (int i = 0; i != _count; i++) {
+            const Entry e = _entries[i];
+            if (e.segment != NONE)
+                pixels[i] = fn(int(e.segment), int(e.index));
+        }
+    }
+
+private:
+    struct Entry {
+        uint16_t segment;
+        uint16_t index;
+    };
+
+    int _count;
+    int _segmentCount;
+    std::unique_ptr<Entry[]> _entries;
+    std::unique_ptr<SegmentRange[]> _ranges;
+};
@@ -7,3 +7,15 @@ SmartLed*& IRAM_ATTR SmartLed::ledForChannel(int channel) {
     assert(channel < detail::CHANNEL_COUNT);
     return table[channel];
 }
+
+SemaphoreHandle_t SpiBus::mutex() {
+    // Function local, so it exists before strips constructed as globals use it
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+}
+
+SpiBus::State& SpiBus::state(spi_host_device_t host) {
+    static State table[SPI_HOST_MAX] = {};
+    assert(host < SPI_HOST_MAX);
+    return table[host];
+}
@@ -28,8 +28,10 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <initializer_list>
 #include <memory>
 
 #include <driver/gpio.h>
@@ -38,8 +40,22 @@
 #include <esp_ipc.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
 
+#include "Canvas.h"
 #include "Color.h"
+#include "Compositor.h"
+#include "Effects.h"
+#include "FixedMath.h"
+#include "FrameStats.h"
+#include "LedOutput.h"
+#include "Matrix.h"
+#include "Noise.h"
+#include "Palette.h"
+#include "Power.h"
+#include "Segments.h"
+#include "Transition.h"
 
 #include "RmtDriver.h"
 
@@ -82,6 +98,10 @@ struct RgbDeleter {
     }
 };
 
+struct HeapCapsDeleter {
+    void operator()(void* ptr) const { heap_caps_free(ptr); }
+};
+
 #if __cpp_exceptions
     #define SMARTLEDS_ALLOC_FAIL() throw std::bad_alloc();
 #else
@@ -89,6 +109,73 @@ struct RgbDeleter {
 #endif
 
 
+// Completion token returned by the asynchronous show of any strip. It is a plain handle
+// to the strip, so it is cheap to copy, but it must not outlive the strip.
+// The token completes once the strip is idle, i.e. also after a later frame is sent.
+//
+// It never blocks unless you call wait(), so a single task can poll tokens of several
+// strips (or a coroutine scheduler can poll ready()) and render in the meantime.
+class ShowToken {
+public:
+    ShowToken()
+        : _strip(nullptr)
+        , _ready(nullptr)
+        , _wait(nullptr)
+        , _err(ESP_OK) {}
+
+    template <class Strip>
+    ShowToken(Strip* strip, esp_err_t err)
+        : _strip(err == ESP_OK ? strip : nullptr)
+        , _ready(readyOf<Strip>)
+        , _wait(waitOf<Strip>)
+        , _err(err) {}
+
+    bool ready() const { return !_strip || _ready(_strip); }
+
+    bool wait(TickType_t timeout = portMAX_DELAY) const { return !_strip || _wait(_strip, timeout); }
+
+    // Result of starting the transmission. Failed transmission is ready immediately.
+    esp_err_t error() const { return _err; }
+
+    static bool allReady(std::initializer_list<ShowToken> tokens) {
+        for (const auto& t : tokens)
+            if (!t.ready())
+                return false;
+        return true;
+    }
+
+    // Waits for all tokens, timeout applies to the whole group.
+    static bool waitAll(std::initializer_list<ShowToken> tokens, TickType_t timeout = portMAX_DELAY) {
+        const TickType_t start = xTaskGetTickCount();
+        for (const auto& t : tokens) {
+            TickType_t left = portMAX_DELAY;
+            if (timeout != portMAX_DELAY) {
+                TickType_t elapsed = xTaskGetTickCount() - start;
+                left = elapsed < timeout ? timeout - elapsed : 0;
+            }
+            if (!t.wait(left))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    template <class Strip>
+    static bool readyOf(void* strip) {
+        return static_cast<Strip*>(strip)->ready();
+    }
+
+    template <class Strip>
+    static bool waitOf(void* strip, TickType_t timeout) {
+        return static_cast<Strip*>(strip)->wait(timeout);
+    }
+
+    void* _strip;
+    bool (*_ready)(void*);
+    bool (*_wait)(void*, TickType_t);
+    esp_err_t _err;
+};
+
 class SmartLed {
 public:
     friend class detail::RmtDriver;
@@ -105,7 +192,19 @@ public:
         IsrCore isrCore = CoreCurrent)
         : _finishedFlag(xSemaphoreCreateBinary())
         , _channel(channel)
-        , _count(count) {
+        , _count(count)
+        , _refreshTimer(nullptr)
+        , _powerModel(POWER_WS2812B)
+        , _powerBudgetMa(0)
+        , _powerScale(255)
+        , _dynamicMa(0)
+        , _tracking(false)
+        , _skipUnchanged(false)
+        , _lastValid(false)
+        , _keepAlive(0)
+        , _lastSent(0)
+        , _sentFrames(0)
+        , _skippedFrames(0) {
         assert(channel >= 0 && channel < detail::CHANNEL_COUNT);
         assert(ledForChannel(channel) == nullptr);
 
@@ -149,6 +248,8 @@ public:
     }
 
     ~SmartLed() {
+        stopRefresh();
+        wait();
         ledForChannel(_channel) = nullptr;
 #if !defined(SOC_CPU_CORES_NUM) || SOC_CPU_CORES_NUM > 1
         if (!anyAlive() && _interruptCore != CoreCurrent) {
@@ -166,7 +267,18 @@ public:
     const Rgb& operator[](int idx) const { return _firstBuffer[idx]; }
 
     esp_err_t show() {
-        esp_err_t err = startTransmission();
+        if (_skipUnchanged && unchanged()) {
+            _skippedFrames++;
+            return ESP_OK;
+        }
+        esp_err_t err = _refreshTimer ? startBakedTransmission() : startTransmission();
+        if (err == ESP_OK) {
+            _sentFrames++;
+            _lastSent = xTaskGetTickCount();
+            if (_lastFrame)
+                std::copy_n(_firstBuffer.get(), _count, _lastFrame.get());
+        }
+        _lastValid = _skipUnchanged && err == ESP_OK;
         swapBuffers();
         return err;
     }
@@ -179,6 +291,175 @@ public:
         return false;
     }
 
+    // Same as show(), but returns a token which can be polled for completion or combined
+    // with tokens of other strips, see ShowToken.
+    ShowToken showAsync() { return ShowToken(this, show()); }
+
+    bool ready() const { return uxSemaphoreGetCount(_finishedFlag) > 0; }
+
+    // Encodes the current buffer into RMT symbols and keeps them, so that showBaked()
+    // can send the same frame repeatedly without running the encoder. The symbols take
+    // 96 bytes of internal RAM per LED (compared to 4 bytes of the Rgb buffer).
+    // Waits for the frame in flight to finish.
+    esp_err_t bake() {
+        xSemaphoreTake(_finishedFlag, portMAX_DELAY);
+        applyPowerLimit();
+        auto err = _driver->bake(_firstBuffer.get());
+        xSemaphoreGive(_finishedFlag);
+        return err;
+    }
+
+    // Makes the encoder send the buffer in a different order: the i-th pixel on the wire is
+    // buffer[order[i]], e.g. MatrixMap::order() lets you draw into the strip buffer as into
+    // a row-major framebuffer, without copying it into strip order. nullptr restores the
+    // plain order. The table (size() entries) must stay alive while it's set.
+    // Waits for the frame in flight to finish, applies from the next show() or bake().
+    void setOrder(const uint16_t* order) {
+        xSemaphoreTake(_finishedFlag, portMAX_DELAY);
+        _driver->setOrder(order);
+        _lastValid = false;
+        xSemaphoreGive(_finishedFlag);
+    }
+
+    // Makes show() skip frames identical to the last one sent, so an unchanged frame doesn't
+    // occupy the RMT channel and its interrupt. With keepAlive != 0, an unchanged frame is
+    // still sent once keepAlive ticks passed since the last transmission.
+    // Frames are compared byte by byte. Double buffered strips have the last frame in the
+    // second buffer, single buffered ones keep a copy of it (4 bytes per LED).
+    void setSkipUnchanged(bool skip, TickType_t keepAlive = 0) {
+        _skipUnchanged = skip;
+        _keepAlive = keepAlive;
+        _lastValid = false;
+        if (skip && !_secondBuffer && !_lastFrame) {
+            auto mem = reinterpret_cast<Rgb*>(heap_caps_malloc(sizeof(Rgb) * _count, MALLOC_CAP_DEFAULT));
+            if (!mem) {
+                SMARTLEDS_ALLOC_FAIL();
+            }
+            _lastFrame.reset(new (mem) Rgb[_count]);
+            _lastFrame.get_deleter().count = _count;
+        } else if (!skip) {
+            _lastFrame.reset();
+        }
+    }
+
+    bool skipUnchanged() const { return _skipUnchanged; }
+    uint32_t sentFrames() const { return _sentFrames; }
+    uint32_t skippedFrames() const { return _skippedFrames; }
+
+    void resetFrameCounters() {
+        _sentFrames = 0;
+        _skippedFrames = 0;
+    }
+
+    // Counters of the RMT driver, all zero unless built with SMARTLEDS_RMT_STATS=1,
+    // see RmtStats.h
+    RmtStats rmtStats() const { return _driver->stats(); }
+    void resetRmtStats() { _driver->resetStats(); }
+
+    // Opt-in frame statistics (see FrameStats.h) which cost O(1) to query. Pixels written
+    // through tracked(idx) keep them up to date; after writing through operator[] or
+    // begin(), call trackStats() again to rescan. The power limit doesn't rely on them,
+    // as any untracked write (Canvas, fillFromPalette, nscale8, ...) makes them stale.
+    void trackStats() {
+        _stats[0].scan(_firstBuffer.get(), _count);
+        if (_secondBuffer)
+            _stats[1].scan(_secondBuffer.get(), _count);
+        _tracking = true;
+    }
+
+    bool trackingStats() const { return _tracking; }
+    TrackedPixel tracked(int idx) { return TrackedPixel(_firstBuffer[idx], _stats[0]); }
+    // Stats of the buffer operator[] writes to
+    const FrameStats& frameStats() const { return _stats[0]; }
+
+    // Keeps the estimated current of every frame at or under budgetMa (e.g. your PSU rating
+    // minus a margin), see Power.h. Frames over the budget are dimmed while they are encoded,
+    // the Rgb buffer is left as it is. budgetMa == 0 turns the limit off.
+    // Applies from the next show() or bake().
+    void setPowerLimit(const PowerModel& model, uint32_t budgetMa) {
+        _powerModel = model;
+        _powerBudgetMa = budgetMa;
+        _lastValid = false;
+    }
+
+    uint32_t powerBudget() const { return _powerBudgetMa; }
+
+    // Brightness the last frame was sent with, 255 if it fit into the budget
+    uint8_t powerScale() const { return _powerScale; }
+
+    // Estimated current of the last frame after limiting (only with a power limit set)
+    uint32_t estimatedCurrentMa() const {
+        return ((uint64_t(_dynamicMa) * (_powerScale + 1)) >> 8) + idleCurrentMa(_powerModel, _count);
+    }
+
+    // Sends the frame stored by the last bake(). Does not touch the Rgb buffers.
+    // While a refresh is running, it waits for the refresh in flight like show() does,
+    // and the refresh keeps repeating the baked frame afterwards.
+    esp_err_t showBaked() {
+        if (_refreshTimer) {
+            xSemaphoreTake(_finishedFlag, portMAX_DELAY);
+        } else if (xSemaphoreTake(_finishedFlag, 0) != pdTRUE) {
+            // Invalid use of the library, you must wait() for previous frame to get processed first
+            abort();
+        }
+
+        // The baked frame need not be the last one shown, don't skip the next show()
+        _lastValid = false;
+        auto err = _driver->transmitBaked();
+        if (err != ESP_OK) {
+            xSemaphoreGive(_finishedFlag);
+        }
+        return err;
+    }
+
+    // Keeps resending the last shown frame every `period` ticks, for strips which need
+    // a periodic refresh. The frame is baked (see bake()), so a refresh is only a copy of
+    // the symbols, the encoder does not run. show() still works in this mode, it waits
+    // for the refresh in flight and replaces the repeated frame atomically.
+    //
+    // Calling it again only changes the period.
+    esp_err_t startRefresh(TickType_t period) {
+        if (_refreshTimer) {
+            return xTimerChangePeriod(_refreshTimer, period, portMAX_DELAY) == pdPASS ? ESP_OK : ESP_FAIL;
+        }
+
+        xSemaphoreTake(_finishedFlag, portMAX_DELAY);
+        auto err = _driver->bake(_secondBuffer ? _secondBuffer.get() : _firstBuffer.get());
+        xSemaphoreGive(_finishedFlag);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        _refreshTimer = xTimerCreate("SmartLedRefresh", period, pdTRUE, this, refreshCallback);
+        if (!_refreshTimer) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (xTimerStart(_refreshTimer, portMAX_DELAY) != pdPASS) {
+            stopRefresh();
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    // Must not be called from a timer callback.
+    void stopRefresh() {
+        if (!_refreshTimer)
+            return;
+
+        xTimerDelete(_refreshTimer, portMAX_DELAY);
+        _refreshTimer = nullptr;
+
+        // The timer task handles commands in order, once this call runs, the deleted
+        // timer can't fire anymore.
+        auto stopped = xSemaphoreCreateBinary();
+        xTimerPendFunctionCall(
+            [](void* stopped, uint32_t) { xSemaphoreGive((SemaphoreHandle_t)stopped); }, stopped, 0, portMAX_DELAY);
+        xSemaphoreTake(stopped, portMAX_DELAY);
+        vSemaphoreDelete(stopped);
+    }
+
+    bool refreshing() const { return _refreshTimer != nullptr; }
+
     int size() const { return _count; }
     int channel() const { return _channel; }
 
@@ -213,8 +494,36 @@ private:
     }
 
     void swapBuffers() {
-        if (_secondBuffer)
+        if (_secondBuffer) {
             _firstBuffer.swap(_secondBuffer);
+            std::swap(_stats[0], _stats[1]);
+        }
+    }
+
+    static void refreshCallback(TimerHandle_t timer) {
+        auto* self = (SmartLed*)pvTimerGetTimerID(timer);
+        // Previous frame is still being sent, skip this period
+        if (xSemaphoreTake(self->_finishedFlag, 0) != pdTRUE)
+            return;
+
+        if (self->_driver->transmitBaked() != ESP_OK) {
+            xSemaphoreGive(self->_finishedFlag);
+        }
+    }
+
+    esp_err_t startBakedTransmission() {
+        // The refresh timer might be sending the previous frame
+        xSemaphoreTake(_finishedFlag, portMAX_DELAY);
+        applyPowerLimit();
+
+        auto err = _driver->bake(_firstBuffer.get());
+        if (err == ESP_OK) {
+            err = _driver->transmitBaked();
+        }
+        if (err != ESP_OK) {
+            xSemaphoreGive(_finishedFlag);
+        }
+        return err;
     }
 
     esp_err_t startTransmission() {
@@ -222,20 +531,60 @@ private:
         if (xSemaphoreTake(_finishedFlag, 0) != pdTRUE)
             abort();
 
+        applyPowerLimit();
         auto err = _driver->transmit(_firstBuffer.get());
         if (err != ESP_OK) {
+            // Nothing is being sent, don't block the next show()
+            xSemaphoreGive(_finishedFlag);
             return err;
         }
 
         return ESP_OK;
     }
 
+    bool unchanged() {
+        if (!_lastValid || (_keepAlive && xTaskGetTickCount() - _lastSent >= _keepAlive))
+            return false;
+        // With double buffering, the last sent frame is the second buffer after the swap
+        const Rgb* last = _secondBuffer ? _secondBuffer.get() : _lastFrame.get();
+        return memcmp(_firstBuffer.get(), last, sizeof(Rgb) * _count) == 0;
+    }
+
+    // One read-only pass over the buffer, the scaling itself runs in the encoder.
+    // Must be called with _finishedFlag taken, the driver is idle then.
+    void applyPowerLimit() {
+        uint8_t scale = 255;
+        if (_powerBudgetMa) {
+            const auto sums = channelSums(_firstBuffer.get(), _count);
+            _dynamicMa = dynamicCurrentMa(_powerModel, sums);
+            scale = ::powerScale(_powerModel, sums, _powerBudgetMa);
+        }
+        _powerScale = scale;
+        _driver->setScale(scale);
+    }
+
     SemaphoreHandle_t _finishedFlag;
     std::unique_ptr<detail::RmtDriver, RmtDriverDeleter> _driver;
     int _channel;
     int _count;
     std::unique_ptr<Rgb[], RgbDeleter> _firstBuffer;
     std::unique_ptr<Rgb[], RgbDeleter> _secondBuffer;
+    TimerHandle_t _refreshTimer;
+    PowerModel _powerModel;
+    uint32_t _powerBudgetMa;
+    uint8_t _powerScale;
+    uint32_t _dynamicMa;
+    FrameStats _stats[2];
+    bool _tracking;
+    bool _skipUnchanged;
+    // The last sent frame is known, see unchanged()
+    bool _lastValid;
+    TickType_t _keepAlive;
+    TickType_t _lastSent;
+    // Copy of the last sent frame, single buffered strips skipping unchanged frames only
+    std::unique_ptr<Rgb[], RgbDeleter> _lastFrame;
+    uint32_t _sentFrames;
+    uint32_t _skippedFrames;
 };
 
 #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
@@ -246,6 +595,146 @@ private:
 #define _SMARTLEDS_SPI_DMA_CHAN 1
 #endif
 
+// Bookkeeping of the SPI buses used by the clocked strips (Apa102, LDP8806). The first strip
+// on a host initializes the bus, the last one to go frees it. Strips sharing a host are
+// separate SPI devices, each needs its own CS pin (or a demultiplexer driven by it).
+// Strips on different hosts transmit in parallel.
+class SpiBus {
+public:
+    // Later users of an already initialized bus must use the same pins and can't need
+    // longer transfers than the first one.
+    static esp_err_t acquire(spi_host_device_t host, int clkpin, int datapin, int maxTransferSize) {
+        Lock lock;
+        return acquireLocked(host, clkpin, datapin, maxTransferSize);
+    }
+
+    static esp_err_t addDevice(
+        spi_host_device_t host, int clock_speed_hz, int cspin, int queueSize, spi_device_handle_t* handle) {
+        spi_device_interface_config_t devcfg;
+        memset(&devcfg, 0, sizeof(devcfg));
+        devcfg.clock_speed_hz = clock_speed_hz;
+        devcfg.mode = 0;
+        devcfg.spics_io_num = cspin;
+        devcfg.queue_size = queueSize;
+        devcfg.pre_cb = nullptr;
+        return spi_bus_add_device(host, &devcfg, handle);
+    }
+
+    // Re-initializes the bus for longer transfers. Only the sole user of the bus can do it,
+    // after removing its device.
+    static esp_err_t grow(spi_host_device_t host, int maxTransferSize) {
+        Lock lock;
+        auto& bus = state(host);
+        if (maxTransferSize <= bus.maxTransferSize)
+            return ESP_OK;
+        if (bus.users != 1)
+            return ESP_ERR_INVALID_SIZE;
+
+        const int clkpin = bus.clkpin, datapin = bus.datapin;
+        auto err = releaseLocked(host);
+        if (err != ESP_OK)
+            return err;
+        return acquireLocked(host, clkpin, datapin, maxTransferSize);
+    }
+
+    static esp_err_t release(spi_host_device_t host) {
+        Lock lock;
+        return releaseLocked(host);
+    }
+
+    static int users(spi_host_device_t host) { return state(host).users; }
+    static int maxTransferSize(spi_host_device_t host) { return state(host).maxTransferSize; }
+
+    static int dmaChannel(spi_host_device_t host) {
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+        return SPI_DMA_CH_AUTO;
+#else
+        return host == HSPI_HOST ? 1 : 2;
+#endif
+    }
+
+private:
+    // Strips can be created and destroyed from several tasks, the bookkeeping and
+    // the bus (re)initialization run under a global mutex
+    struct Lock {
+        Lock() { xSemaphoreTake(mutex(), portMAX_DELAY); }
+        ~Lock() { xSemaphoreGive(mutex()); }
+    };
+
+    static SemaphoreHandle_t mutex();
+
+    static esp_err_t acquireLocked(spi_host_device_t host, int clkpin, int datapin, int maxTransferSize) {
+        auto& bus = state(host);
+        if (bus.users > 0) {
+            if (bus.clkpin != clkpin || bus.datapin != datapin)
+                return ESP_ERR_INVALID_ARG;
+            if (maxTransferSize > bus.maxTransferSize)
+                return ESP_ERR_INVALID_SIZE;
+            bus.users++;
+            return ESP_OK;
+        }
+
+        spi_bus_config_t buscfg;
+        memset(&buscfg, 0, sizeof(buscfg));
+        buscfg.mosi_io_num = datapin;
+        buscfg.miso_io_num = -1;
+        buscfg.sclk_io_num = clkpin;
+        buscfg.quadwp_io_num = -1;
+        buscfg.quadhd_io_num = -1;
+        buscfg.max_transfer_sz = maxTransferSize;
+
+        auto err = spi_bus_initialize(host, &buscfg, dmaChannel(host));
+        if (err != ESP_OK)
+            return err;
+
+        bus.users = 1;
+        bus.clkpin = clkpin;
+        bus.datapin = datapin;
+        bus.maxTransferSize = maxTransferSize;
+        return ESP_OK;
+    }
+
+    static esp_err_t releaseLocked(spi_host_device_t host) {
+        auto& bus = state(host);
+        if (bus.users == 0)
+            return ESP_ERR_INVALID_STATE;
+        if (--bus.users > 0)
+            return ESP_OK;
+        return spi_bus_free(host);
+    }
+
+    struct State {
+        int users;
+        int clkpin;
+        int datapin;
+        int maxTransferSize;
+    };
+
+    static State& state(spi_host_device_t host);
+};
+
+namespace detail {
+
+// 255 * 31 / (65535 * brightness) for every 5-bit brightness, fixed point with 19 fractional bits
+struct ApaHdrScale {
+    static const int SHIFT = 19;
+    uint16_t value[32];
+
+    constexpr ApaHdrScale()
+        : value() {
+        for (uint32_t brightness = 1; brightness != 32; brightness++) {
+            const uint64_t divisor = 65535 * brightness;
+            value[brightness] = ((uint64_t(255 * 31) << SHIFT) + divisor / 2) / divisor;
+        }
+    }
+};
+
+} // namespace detail
+
+// SeparateFrames == start frame, pixels and end frame are sent as separate SPI transactions
+// ContiguousFrame == all of them live in one DMA-capable buffer, sent as a single transaction
+enum FrameLayout { SeparateFrames = 0, ContiguousFrame };
+
 // Can also handle SK9822
 class Apa102 {
 public:
@@ -271,122 +760,275 @@ public:
         uint8_t v, b, g, r;
     };
 
-    static const int FINAL_FRAME_SIZE = 4;
-    static const int TRANS_COUNT = 2 + 8;
-
-    Apa102(int count, int clkpin, int datapin, BufferType doubleBuffer = SingleBuffer, int clock_speed_hz = 1000000)
-        : _count(count)
-        , _firstBuffer(new ApaRgb[count])
-        , _secondBuffer(doubleBuffer ? new ApaRgb[count] : nullptr)
-        , _transCount(0)
-        , _initFrame(0) {
-        spi_bus_config_t buscfg;
-        memset(&buscfg, 0, sizeof(buscfg));
-        buscfg.mosi_io_num = datapin;
-        buscfg.miso_io_num = -1;
-        buscfg.sclk_io_num = clkpin;
-        buscfg.quadwp_io_num = -1;
-        buscfg.quadhd_io_num = -1;
-        buscfg.max_transfer_sz = 65535;
-
-        spi_device_interface_config_t devcfg;
-        memset(&devcfg, 0, sizeof(devcfg));
-        devcfg.clock_speed_hz = clock_speed_hz;
-        devcfg.mode = 0;
-        devcfg.spics_io_num = -1;
-        devcfg.queue_size = TRANS_COUNT;
-        devcfg.pre_cb = nullptr;
+    static const int START_FRAME_SIZE = 4;
+    // Start frame, pixels, end frame
+    static const int TRANS_COUNT = 3;
+
+    // https://cpldcpu.com/2016/12/13/sk9822-a-clone-of-the-apa102/ - "Unified protocol"
+    static int endFrameBits(int count) { return 32 + (count / 2 + 1); }
+    static int frameBits(int count) { return 8 * START_FRAME_SIZE + 32 * count + endFrameBits(count); }
+
+    // High dynamic range conversion. The 16 bits per channel are split into the 5-bit global
+    // brightness and the 8-bit PWM: the lowest brightness which still fits the brightest
+    // channel is used, which leaves the finest PWM steps for the channels.
+    // Note that APA102 dims the global brightness by a slow PWM, SK9822 by the LED current.
+    static void convertHdr(const Rgb16* src, ApaRgb* dest, int count) {
+        using Scale = detail::ApaHdrScale;
+        static constexpr Scale scale {};
+        for (int i = 0; i != count; i++) {
+            const auto& c = src[i];
+            const uint32_t max = std::max(c.r, std::max(c.g, c.b));
+            const uint32_t brightness = std::max<uint32_t>(1, (max * 31 + 65534) / 65535);
+            const uint32_t mul = scale.value[brightness];
+            auto pwm = [mul](uint32_t channel) {
+                return uint8_t(std::min<uint32_t>(255, (channel * mul + (1 << (Scale::SHIFT - 1))) >> Scale::SHIFT));
+            };
+            dest[i].v = 0xE0 | brightness;
+            dest[i].r = pwm(c.r);
+            dest[i].g = pwm(c.g);
+            dest[i].b = pwm(c.b);
+        }
+    }
 
-        auto ret = spi_bus_initialize(_SMARTLEDS_SPI_HOST, &buscfg, _SMARTLEDS_SPI_DMA_CHAN);
+    // Strips on the same host need a CS pin each, see SpiBus.
+    Apa102(int count, int clkpin, int datapin, BufferType doubleBuffer = SingleBuffer, int clock_speed_hz = 1000000,
+        FrameLayout layout = SeparateFrames, spi_host_device_t host = _SMARTLEDS_SPI_HOST, int cspin = -1)
+        : _host(host)
+        , _cspin(cspin)
+        , _clockSpeed(clock_speed_hz)
+        , _count(0)
+        , _capacity(0)
+        , _layout(layout)
+        , _doubleBuffer(doubleBuffer)
+        , _transCount(0) {
+        allocate(count);
+
+        auto ret = SpiBus::acquire(host, clkpin, datapin, maxTransferSize(count, layout));
         assert(ret == ESP_OK);
 
-        ret = spi_bus_add_device(_SMARTLEDS_SPI_HOST, &devcfg, &_spi);
+        ret = SpiBus::addDevice(host, clock_speed_hz, cspin, TRANS_COUNT, &_spi);
         assert(ret == ESP_OK);
-
-        std::fill_n(_finalFrame, FINAL_FRAME_SIZE, 0);
     }
 
     ~Apa102() {
-        // ToDo
+        wait();
+        spi_bus_remove_device(_spi);
+        SpiBus::release(_host);
+    }
+
+    // Changes the strip length and the clock at runtime, waits for the frame in flight first.
+    // Buffers are reused when the new length fits into them, so the heap is only touched when
+    // the strip grows over its largest length so far. Pixels which stay keep their color.
+    esp_err_t reconfigure(int count, int clock_speed_hz) {
+        wait();
+
+        const int maxTransfer = maxTransferSize(count, _layout);
+        if (clock_speed_hz != _clockSpeed || maxTransfer > SpiBus::maxTransferSize(_host)) {
+            auto err = spi_bus_remove_device(_spi);
+            if (err != ESP_OK)
+                return err;
+
+            const auto growErr = SpiBus::grow(_host, maxTransfer);
+            if (growErr == ESP_OK)
+                _clockSpeed = clock_speed_hz;
+
+            err = SpiBus::addDevice(_host, _clockSpeed, _cspin, TRANS_COUNT, &_spi);
+            if (growErr != ESP_OK)
+                return growErr;
+            if (err != ESP_OK)
+                return err;
+        }
+
+        allocate(count);
+        return ESP_OK;
     }
 
-    ApaRgb& operator[](int idx) { return _firstBuffer[idx]; }
+    int size() const { return _count; }
+
+    ApaRgb& operator[](int idx) { return pixels(_firstBuffer.get())[idx]; }
+
+    const ApaRgb& operator[](int idx) const { return pixels(_firstBuffer.get())[idx]; }
 
-    const ApaRgb& operator[](int idx) const { return _firstBuffer[idx]; }
+    // Fills the whole strip from 16-bit colors, see convertHdr()
+    void setHdr(const Rgb16* src) { convertHdr(src, pixels(_firstBuffer.get()), _count); }
 
-    void show() {
+    ApaRgb* begin() { return pixels(_firstBuffer.get()); }
+    const ApaRgb* begin() const { return pixels(_firstBuffer.get()); }
+    ApaRgb* end() { return begin() + _count; }
+    const ApaRgb* end() const { return begin() + _count; }
+
+    // Waits for the previous frame, if you haven't done so
+    esp_err_t show() {
+        wait();
         _buffer = _firstBuffer.get();
-        startTransmission();
+        auto err = startTransmission();
         swapBuffers();
+        return err;
     }
 
-    void wait() {
-        for (int i = 0; i != _transCount; i++) {
+    ShowToken showAsync() { return ShowToken(this, show()); }
+
+    // The timeout applies to each of the frame's transactions
+    bool wait(TickType_t timeout = portMAX_DELAY) {
+        for (; _transCount > 0; _transCount--) {
             spi_transaction_t* t;
-            spi_device_get_trans_result(_spi, &t, portMAX_DELAY);
+            if (spi_device_get_trans_result(_spi, &t, timeout) != ESP_OK)
+                return false;
         }
+        return true;
     }
 
+    bool ready() { return wait(0); }
+
 private:
+    static int frameSize(int count, FrameLayout layout) {
+        if (layout == ContiguousFrame)
+            return (frameBits(count) + 7) / 8;
+        return sizeof(ApaRgb) * count;
+    }
+
+    static int maxTransferSize(int count, FrameLayout layout) { return std::max(65535, frameSize(count, layout)); }
+
+    static uint8_t* allocateDma(int size) {
+        auto* mem = reinterpret_cast<uint8_t*>(heap_caps_calloc(size, 1, MALLOC_CAP_DMA));
+        if (!mem) {
+            SMARTLEDS_ALLOC_FAIL();
+        }
+        return mem;
+    }
+
+    // Sets the strip length, reallocating the buffers only if they are too small
+    void allocate(int count) {
+        if (count > _capacity) {
+            const int size = frameSize(count, _layout);
+            std::unique_ptr<uint8_t[], HeapCapsDeleter> first(allocateDma(size));
+            std::unique_ptr<uint8_t[], HeapCapsDeleter> second(_doubleBuffer ? allocateDma(size) : nullptr);
+            if (_count > 0) {
+                std::copy_n(pixels(_firstBuffer.get()), _count, pixels(first.get()));
+                if (second)
+                    std::copy_n(pixels(_secondBuffer.get()), _count, pixels(second.get()));
+            }
+            _firstBuffer = std::move(first);
+            _secondBuffer = std::move(second);
+
+            if (_layout == SeparateFrames) {
+                // Zeros for both the start and the end frame
+                _zeroFrame.reset(allocateDma(std::max(START_FRAME_SIZE, (endFrameBits(count) + 7) / 8)));
+            }
+            _capacity = count;
+        }
+
+        resizeFrame(_firstBuffer.get(), count);
+        if (_secondBuffer)
+            resizeFrame(_secondBuffer.get(), count);
+        _count = count;
+    }
+
+    // Initializes the pixels added to the frame and zeroes the end frame behind the last pixel
+    void resizeFrame(uint8_t* frame, int count) {
+        if (count > _count)
+            new (pixels(frame) + _count) ApaRgb[count - _count];
+        if (_layout == ContiguousFrame) {
+            auto* end = reinterpret_cast<uint8_t*>(pixels(frame) + count);
+            std::fill(end, frame + frameSize(count, _layout), 0);
+        }
+    }
+
+    ApaRgb* pixels(uint8_t* frame) const {
+        return reinterpret_cast<ApaRgb*>(frame + (_layout == ContiguousFrame ? START_FRAME_SIZE : 0));
+    }
+
     void swapBuffers() {
         if (_secondBuffer)
             _firstBuffer.swap(_secondBuffer);
     }
 
-    void startTransmission() {
-        for (int i = 0; i != TRANS_COUNT; i++) {
-            _transactions[i].cmd = 0;
-            _transactions[i].addr = 0;
-            _transactions[i].flags = 0;
-            _transactions[i].rxlength = 0;
-            _transactions[i].rx_buffer = nullptr;
-        }
+    esp_err_t queue(const void* data, size_t bits) {
+        auto& t = _transactions[_transCount];
+        t.cmd = 0;
+        t.addr = 0;
+        t.flags = 0;
+        t.rxlength = 0;
+        t.rx_buffer = nullptr;
+        t.length = bits;
+        t.tx_buffer = data;
+        auto err = spi_device_queue_trans(_spi, &t, portMAX_DELAY);
+        if (err == ESP_OK)
+            _transCount++;
+        return err;
+    }
+
+    esp_err_t startTransmission() {
+        if (_layout == ContiguousFrame)
+            return queue(_buffer, frameBits(_count));
+
         // Init frame
-        _transactions[0].length = 32;
-        _transactions[0].tx_buffer = &_initFrame;
-        spi_device_queue_trans(_spi, _transactions + 0, portMAX_DELAY);
+        auto err = queue(_zeroFrame.get(), 8 * START_FRAME_SIZE);
         // Data
-        _transactions[1].length = 32 * _count;
-        _transactions[1].tx_buffer = _buffer;
-        spi_device_queue_trans(_spi, _transactions + 1, portMAX_DELAY);
-        _transCount = 2;
-        // End frame
-        // https://cpldcpu.com/2016/12/13/sk9822-a-clone-of-the-apa102/ - "Unified protocol"
-        const int end_bits = 32 + (_count/2 + 1);
-        for (int i = 0; i < end_bits; i += 32 * FINAL_FRAME_SIZE) {
-            _transactions[2 + i].length = std::min(32 * FINAL_FRAME_SIZE, end_bits - i);
-            _transactions[2 + i].tx_buffer = _finalFrame;
-            spi_device_queue_trans(_spi, _transactions + 2 + i, portMAX_DELAY);
-            _transCount++;
-        }
+        if (err == ESP_OK)
+            err = queue(pixels(_buffer), 32 * _count);
+        // End frame, the zero buffer is sized for the whole of it
+        if (err == ESP_OK)
+            err = queue(_zeroFrame.get(), endFrameBits(_count));
+        return err;
     }
 
+    spi_host_device_t _host;
+    int _cspin;
+    int _clockSpeed;
     spi_device_handle_t _spi;
     int _count;
-    std::unique_ptr<ApaRgb[]> _firstBuffer, _secondBuffer;
-    ApaRgb* _buffer;
+    int _capacity;
+    FrameLayout _layout;
+    bool _doubleBuffer;
+    std::unique_ptr<uint8_t[], HeapCapsDeleter> _firstBuffer, _secondBuffer;
+    uint8_t* _buffer;
 
     spi_transaction_t _transactions[TRANS_COUNT];
     int _transCount;
 
-    uint32_t _initFrame;
-    uint32_t _finalFrame[FINAL_FRAME_SIZE];
+    std::unique_ptr<uint8_t[], HeapCapsDeleter> _zeroFrame;
 };
 
+namespace detail {
+
+// 8-bit channel -> LDP8806 7-bit wire value (with the MSB set), optionally gamma corrected
+struct Ldp8806Lut {
+    uint8_t value[256];
+
+    constexpr Ldp8806Lut(bool gamma)
+        : value() {
+        for (uint32_t c = 0; c != 256; c++) {
+            if (gamma) {
+                // x^3, same as Rgb::linearize(), but without the WS2812 bias
+                const uint64_t full = 255 * 255 * 255;
+                value[c] = 0x80 | ((uint64_t(c) * c * c * 127 + full / 2) / full);
+            } else {
+                value[c] = 0x80 | ((c * 127 + 127) / 255);
+            }
+        }
+    }
+};
+
+} // namespace detail
+
 class LDP8806 {
 public:
+    static constexpr detail::Ldp8806Lut LINEAR_LUT { false };
+    static constexpr detail::Ldp8806Lut GAMMA_LUT { true };
+
     struct LDP8806_GRB {
 
         LDP8806_GRB(uint8_t g_7bit = 0, uint8_t r_7bit = 0, uint32_t b_7bit = 0)
-            : g(g_7bit)
-            , r(r_7bit)
-            , b(b_7bit) {}
+            : g(0x80 | g_7bit)
+            , r(0x80 | r_7bit)
+            , b(0x80 | b_7bit) {}
 
         LDP8806_GRB& operator=(const Rgb& o) {
             //Convert 8->7bit colour
-            r = (o.r * 127 / 256) | 0x80;
-            g = (o.g * 127 / 256) | 0x80;
-            b = (o.b * 127 / 256) | 0x80;
+            r = LINEAR_LUT.value[o.r];
+            g = LINEAR_LUT.value[o.g];
+            b = LINEAR_LUT.value[o.b];
             return *this;
         }
 
@@ -398,103 +1040,189 @@ public:
         uint8_t g, r, b;
     };
 
+    // Converts a whole buffer, 255 maps to the full scale 127
+    static void convert(const Rgb* src, LDP8806_GRB* dest, int count, bool gamma = false) {
+        const uint8_t* lut = gamma ? GAMMA_LUT.value : LINEAR_LUT.value;
+        for (int i = 0; i != count; i++) {
+            dest[i].g = lut[src[i].g];
+            dest[i].r = lut[src[i].r];
+            dest[i].b = lut[src[i].b];
+        }
+    }
+
     static const int LED_FRAME_SIZE_BYTES = sizeof(LDP8806_GRB);
     static const int LATCH_FRAME_SIZE_BYTES = 3;
-    static const int TRANS_COUNT_MAX = 20; //Arbitrary, supports up to 600 LED
-
-    LDP8806(
-        int count, int clkpin, int datapin, BufferType doubleBuffer = SingleBuffer, uint32_t clock_speed_hz = 2000000)
-        : _count(count)
-        , _firstBuffer(new LDP8806_GRB[count])
-        , _secondBuffer(doubleBuffer ? new LDP8806_GRB[count] : nullptr)
-        ,
-        // one 'latch'/start-of-data mark frame for every 32 leds
-        _latchFrames((count + 31) / 32) {
-        spi_bus_config_t buscfg;
-        memset(&buscfg, 0, sizeof(buscfg));
-        buscfg.mosi_io_num = datapin;
-        buscfg.miso_io_num = -1;
-        buscfg.sclk_io_num = clkpin;
-        buscfg.quadwp_io_num = -1;
-        buscfg.quadhd_io_num = -1;
-        buscfg.max_transfer_sz = 65535;
-
-        spi_device_interface_config_t devcfg;
-        memset(&devcfg, 0, sizeof(devcfg));
-        devcfg.clock_speed_hz = clock_speed_hz;
-        devcfg.mode = 0;
-        devcfg.spics_io_num = -1;
-        devcfg.queue_size = TRANS_COUNT_MAX;
-        devcfg.pre_cb = nullptr;
-
-        auto ret = spi_bus_initialize(_SMARTLEDS_SPI_HOST, &buscfg, _SMARTLEDS_SPI_DMA_CHAN);
+    // Pixels and latch frames go out in one transaction
+    static const int TRANS_COUNT = 1;
+
+    // one 'latch'/start-of-data mark frame for every 32 leds
+    static int latchFrames(int count) { return (count + 31) / 32; }
+    static int frameSize(int count) { return LED_FRAME_SIZE_BYTES * count + LATCH_FRAME_SIZE_BYTES * latchFrames(count); }
+
+    // Strips on the same host need a CS pin each, see SpiBus.
+    LDP8806(int count, int clkpin, int datapin, BufferType doubleBuffer = SingleBuffer,
+        uint32_t clock_speed_hz = 2000000, spi_host_device_t host = _SMARTLEDS_SPI_HOST, int cspin = -1)
+        : _host(host)
+        , _cspin(cspin)
+        , _clockSpeed(clock_speed_hz)
+        , _count(0)
+        , _capacity(0)
+        , _doubleBuffer(doubleBuffer)
+        , _transCount(0) {
+        allocate(count);
+
+        auto ret = SpiBus::acquire(host, clkpin, datapin, maxTransferSize(count));
         assert(ret == ESP_OK);
 
-        ret = spi_bus_add_device(_SMARTLEDS_SPI_HOST, &devcfg, &_spi);
+        ret = SpiBus::addDevice(host, clock_speed_hz, cspin, TRANS_COUNT, &_spi);
         assert(ret == ESP_OK);
-
-        std::fill_n(_latchBuffer, LATCH_FRAME_SIZE_BYTES, 0x0);
     }
 
     ~LDP8806() {
-        // noop
+        wait();
+        spi_bus_remove_device(_spi);
+        SpiBus::release(_host);
     }
 
+    // Changes the strip length and the clock at runtime, waits for the frame in flight first.
+    // Buffers are reused when the new length fits into them, pixels which stay keep their color.
+    // Growing over the SPI bus transfer size is only possible when the strip is the only user
+    // of its host.
+    esp_err_t reconfigure(int count, uint32_t clock_speed_hz) {
+        wait();
+
+        const int maxTransfer = maxTransferSize(count);
+        if (clock_speed_hz != _clockSpeed || maxTransfer > SpiBus::maxTransferSize(_host)) {
+            auto err = spi_bus_remove_device(_spi);
+            if (err != ESP_OK)
+                return err;
+
+            const auto growErr = SpiBus::grow(_host, maxTransfer);
+            if (growErr == ESP_OK)
+                _clockSpeed = clock_speed_hz;
+
+            err = SpiBus::addDevice(_host, _clockSpeed, _cspin, TRANS_COUNT, &_spi);
+            if (growErr != ESP_OK)
+                return growErr;
+            if (err != ESP_OK)
+                return err;
+        }
+
+        allocate(count);
+        return ESP_OK;
+    }
+
+    int size() const { return _count; }
+
     LDP8806_GRB& operator[](int idx) { return _firstBuffer[idx]; }
 
     const LDP8806_GRB& operator[](int idx) const { return _firstBuffer[idx]; }
 
-    void show() {
+    LDP8806_GRB* begin() { return _firstBuffer.get(); }
+    const LDP8806_GRB* begin() const { return _firstBuffer.get(); }
+    LDP8806_GRB* end() { return _firstBuffer.get() + _count; }
+    const LDP8806_GRB* end() const { return _firstBuffer.get() + _count; }
+
+    // Waits for the previous frame, if you haven't done so
+    esp_err_t show() {
+        wait();
         _buffer = _firstBuffer.get();
-        startTransmission();
+        auto err = startTransmission();
         swapBuffers();
+        return err;
+    }
+
+    // Converts the Rgb buffer (size() pixels) into the DMA buffer and shows it. Lets you draw
+    // into your own Rgb buffer and keep only a single LDP8806 buffer as the staging area.
+    esp_err_t show(const Rgb* pixels, bool gamma = false) {
+        wait();
+        convert(pixels, _firstBuffer.get(), _count, gamma);
+        return show();
     }
 
-    void wait() {
-        while (_transCount--) {
+    ShowToken showAsync() { return ShowToken(this, show()); }
+
+    bool wait(TickType_t timeout = portMAX_DELAY) {
+        for (; _transCount > 0; _transCount--) {
             spi_transaction_t* t;
-            spi_device_get_trans_result(_spi, &t, portMAX_DELAY);
+            if (spi_device_get_trans_result(_spi, &t, timeout) != ESP_OK)
+                return false;
         }
+        return true;
     }
 
+    bool ready() { return wait(0); }
+
 private:
+    static int maxTransferSize(int count) { return std::max(65535, frameSize(count)); }
+
+    // The latch frames behind the pixels are zeroed by calloc
+    static LDP8806_GRB* allocateDma(int count) {
+        auto* mem = reinterpret_cast<LDP8806_GRB*>(heap_caps_calloc(frameSize(count), 1, MALLOC_CAP_DMA));
+        if (!mem) {
+            SMARTLEDS_ALLOC_FAIL();
+        }
+        return new (mem) LDP8806_GRB[count];
+    }
+
+    // Sets the strip length, reallocating the buffers only if they are too small
+    void allocate(int count) {
+        if (count > _capacity) {
+            std::unique_ptr<LDP8806_GRB[], HeapCapsDeleter> first(allocateDma(count));
+            std::unique_ptr<LDP8806_GRB[], HeapCapsDeleter> second(_doubleBuffer ? allocateDma(count) : nullptr);
+            std::copy_n(_firstBuffer.get(), _count, first.get());
+            if (second)
+                std::copy_n(_secondBuffer.get(), _count, second.get());
+            _firstBuffer = std::move(first);
+            _secondBuffer = std::move(second);
+            _capacity = count;
+        }
+
+        resizeFrame(_firstBuffer.get(), count);
+        if (_secondBuffer)
+            resizeFrame(_secondBuffer.get(), count);
+        _count = count;
+    }
+
+    // Initializes the pixels added to the frame and zeroes the latch frames behind the last pixel
+    void resizeFrame(LDP8806_GRB* frame, int count) {
+        if (count > _count)
+            new (frame + _count) LDP8806_GRB[count - _count];
+        auto* latch = reinterpret_cast<uint8_t*>(frame + count);
+        std::fill_n(latch, LATCH_FRAME_SIZE_BYTES * latchFrames(count), 0);
+    }
+
     void swapBuffers() {
         if (_secondBuffer)
             _firstBuffer.swap(_secondBuffer);
     }
 
-    void startTransmission() {
-        _transCount = 0;
-        for (int i = 0; i != TRANS_COUNT_MAX; i++) {
-            _transactions[i].cmd = 0;
-            _transactions[i].addr = 0;
-            _transactions[i].flags = 0;
-            _transactions[i].rxlength = 0;
-            _transactions[i].rx_buffer = nullptr;
-        }
-        // LED Data
-        _transactions[0].length = (LED_FRAME_SIZE_BYTES * 8) * _count;
-        _transactions[0].tx_buffer = _buffer;
-        spi_device_queue_trans(_spi, _transactions + _transCount, portMAX_DELAY);
-        _transCount++;
-
-        // 'latch'/start-of-data marker frames
-        for (int i = 0; i < _latchFrames; i++) {
-            _transactions[_transCount].length = (LATCH_FRAME_SIZE_BYTES * 8);
-            _transactions[_transCount].tx_buffer = _latchBuffer;
-            spi_device_queue_trans(_spi, _transactions + _transCount, portMAX_DELAY);
-            _transCount++;
-        }
+    esp_err_t startTransmission() {
+        _transaction.cmd = 0;
+        _transaction.addr = 0;
+        _transaction.flags = 0;
+        _transaction.rxlength = 0;
+        _transaction.rx_buffer = nullptr;
+
+        // LED data followed by the 'latch'/start-of-data marker frames
+        _transaction.length = 8 * frameSize(_count);
+        _transaction.tx_buffer = _buffer;
+        auto err = spi_device_queue_trans(_spi, &_transaction, portMAX_DELAY);
+        if (err == ESP_OK)
+            _transCount = 1;
+        return err;
     }
 
+    spi_host_device_t _host;
+    int _cspin;
+    uint32_t _clockSpeed;
     spi_device_handle_t _spi;
     int _count;
-    std::unique_ptr<LDP8806_GRB[]> _firstBuffer, _secondBuffer;
+    int _capacity;
+    bool _doubleBuffer;
+    std::unique_ptr<LDP8806_GRB[], HeapCapsDeleter> _firstBuffer, _secondBuffer;
     LDP8806_GRB* _buffer;
 
-    spi_transaction_t _transactions[TRANS_COUNT_MAX];
+    spi_transaction_t _transaction;
     int _transCount;
-
-    int _latchFrames;
-    uint8_t _latchBuffer[LATCH_FRAME_SIZE_BYTES];
 };
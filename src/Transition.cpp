@@ -0,0 +1,69 @@
+#include "Transition.h"
+
+#include <algorithm>
+
+void crossfade(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac) {
+    // 0..256, so that 255 gives exactly `to`
+    const uint32_t f = frac + (frac >> 7);
+    const uint32_t inv = 256 - f;
+    for (int i = 0; i != count; i++) {
+        // Two channels per multiplication, 8 bits of headroom between them
+        const uint32_t a = from[i].value, b = to[i].value;
+        const uint32_t even = (((a & 0x00FF00FF) * inv + (b & 0x00FF00FF) * f) >> 8) & 0x00FF00FF;
+        const uint32_t odd = (((a >> 8) & 0x00FF00FF) * inv + ((b >> 8) & 0x00FF00FF) * f) & 0xFF00FF00;
+        dest[i].value = even | odd;
+    }
+}
+
+void wipe(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac) {
+    // Edge position in 1/256 of a pixel
+    const uint32_t pos = uint32_t(frac + (frac >> 7)) * count;
+    const int full = std::min<int>(pos >> 8, count);
+    std::copy(to, to + full, dest);
+    if (full != count) {
+        crossfade(dest + full, from + full, to + full, 1, pos & 0xFF);
+        std::copy(from + full + 1, from + count, dest + full + 1);
+    }
+}
+
+void dissolve(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac, uint32_t seed) {
+    for (int i = 0; i != count; i++) {
+        // Multiplicative hash, the top byte is the threshold of the pixel
+        const uint8_t threshold = ((uint32_t(i) ^ seed) * 2654435761u) >> 24;
+        dest[i] = threshold < frac || frac == 255 ? to[i] : from[i];
+    }
+}
+
+uint8_t Transition::progress(uint32_t nowMs) const {
+    if (!active(nowMs))
+        return 255;
+    return (uint64_t(nowMs - _startMs) * 255) / _durationMs;
+}
+
+void Transition::render(LedSpan<Rgb> leds, uint32_t timeMs) {
+    if (!_to)
+        return;
+    if (!active(timeMs)) {
+        _from = nullptr;
+        _to->render(leds, timeMs);
+        return;
+    }
+
+    LedSpan<Rgb> outgoing(_outgoing.get(), std::min(_count, leds.size()));
+    if (_frame++ % _divider == 0)
+        _from->render(outgoing, timeMs);
+    _to->render(leds, timeMs);
+
+    const uint8_t frac = progress(timeMs);
+    switch (_type) {
+    case TransitionCrossfade:
+        crossfade(leds.data(), outgoing.data(), leds.data(), outgoing.size(), frac);
+        break;
+    case TransitionWipe:
+        wipe(leds.data(), outgoing.data(), leds.data(), outgoing.size(), frac);
+        break;
+    case TransitionDissolve:
+        dissolve(leds.data(), outgoing.data(), leds.data(), outgoing.size(), frac);
+        break;
+    }
+}
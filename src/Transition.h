@@ -0,0 +1,72 @@
+#pragma once
+
+// Transitions between two effects (scenes). The kernels mix whole Rgb buffers with an
+// 8-bit fraction (0 = from, 255 = to), without the square roots of Rgb::blend.
+
+#include <cstdint>
+#include <memory>
+
+#include "Color.h"
+#include "Effects.h"
+
+// dest may be the same buffer as from or to
+void crossfade(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac);
+// The first frac / 255 of the buffer shows to, with one blended pixel at the edge
+void wipe(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac);
+// Pixels switch from one buffer to the other in a pseudo-random order given by the seed
+void dissolve(Rgb* dest, const Rgb* from, const Rgb* to, int count, uint8_t frac, uint32_t seed = 0);
+
+enum TransitionType { TransitionCrossfade = 0, TransitionWipe, TransitionDissolve };
+
+// Effect which shows the incoming effect, mixed with the outgoing one while a transition
+// runs. To save CPU, the outgoing effect can be rendered only every n-th frame, its last
+// frame is kept in an extra Rgb buffer.
+class Transition : public Effect {
+public:
+    Transition(int count)
+        : _count(count)
+        , _from(nullptr)
+        , _to(nullptr)
+        , _outgoing(new Rgb[count])
+        , _type(TransitionCrossfade)
+        , _startMs(0)
+        , _durationMs(0)
+        , _divider(1)
+        , _frame(0) {}
+
+    // Shows `to` from now on. Without a transition in progress, it's rendered right away.
+    void show(Effect& to) {
+        _to = &to;
+        _from = nullptr;
+    }
+
+    // Starts the transition from the current effect to `to`
+    void start(Effect& to, TransitionType type, uint32_t durationMs, uint32_t nowMs, int outgoingDivider = 1) {
+        _from = _to;
+        _to = &to;
+        _type = type;
+        _startMs = nowMs;
+        _durationMs = durationMs;
+        _divider = outgoingDivider > 0 ? outgoingDivider : 1;
+        _frame = 0;
+    }
+
+    bool active(uint32_t nowMs) const { return _from && nowMs - _startMs < _durationMs; }
+
+    // 0..255 progress of the running transition
+    uint8_t progress(uint32_t nowMs) const;
+
+    void render(LedSpan<Rgb> leds, uint32_t timeMs) override;
+    const char* name() const override { return "transition"; }
+
+private:
+    int _count;
+    Effect* _from;
+    Effect* _to;
+    std::unique_ptr<Rgb[]> _outgoing;
+    TransitionType _type;
+    uint32_t _startMs;
+    uint32_t _durationMs;
+    int _divider;
+    uint32_t _frame;
+};
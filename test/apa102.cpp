@@ -0,0 +1,163 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <driver/spi_test_helpers.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> expectedStream(const std::vector<Rgb>& pixels) {
+    std::vector<uint8_t> stream(Apa102::START_FRAME_SIZE, 0);
+    for (const auto& p : pixels) {
+        stream.insert(stream.end(), { 0xFF, p.b, p.g, p.r });
+    }
+    stream.resize((Apa102::frameBits(pixels.size()) + 7) / 8, 0);
+    return stream;
+}
+
+std::vector<Rgb> testPixels(int count) {
+    std::vector<Rgb> pixels;
+    for (int i = 0; i != count; i++)
+        pixels.emplace_back(i, 2 * i, 255 - i);
+    return pixels;
+}
+
+} // namespace
+
+TEST_CASE("Apa102 contiguous frame is sent as a single transaction", "[apa102]") {
+    resetSpi();
+    const int count = 60;
+    auto pixels = testPixels(count);
+    Apa102 leds(count, 1, 2, DoubleBuffer, 1000000, ContiguousFrame);
+    for (int i = 0; i != count; i++)
+        leds[i] = pixels[i];
+
+    leds.show();
+    leds.wait();
+    REQUIRE(mock::spi.transactions == 1);
+    REQUIRE(mock::spi.bits == size_t(Apa102::frameBits(count)));
+    REQUIRE(mock::spi.wire == expectedStream(pixels));
+}
+
+TEST_CASE("Apa102 separate frames send the same stream", "[apa102]") {
+    resetSpi();
+    const int count = 60;
+    auto pixels = testPixels(count);
+    Apa102 leds(count, 1, 2);
+    for (int i = 0; i != count; i++)
+        leds[i] = pixels[i];
+
+    leds.show();
+    leds.wait();
+    REQUIRE(mock::spi.transactions == 3);
+    REQUIRE(mock::spi.bits == size_t(Apa102::frameBits(count)));
+    REQUIRE(mock::spi.wire == expectedStream(pixels));
+}
+
+TEST_CASE("Apa102 clocks out the exact frame length for 1 to 10000 LEDs", "[apa102]") {
+    for (auto layout : { SeparateFrames, ContiguousFrame }) {
+        for (int count = 1; count <= 10000; count++) {
+            resetSpi(false);
+            Apa102 leds(count, 1, 2, SingleBuffer, 1000000, layout);
+            leds.show();
+            leds.wait();
+
+            // 32 bit start frame, 32 bits per LED, 32 bit reset frame and count/2 clocks
+            const size_t expectedBits = 32 + 32 * count + 32 + count / 2 + 1;
+            CAPTURE(count, int(layout));
+            REQUIRE(mock::spi.bits == expectedBits);
+            REQUIRE(mock::spi.transactions == (layout == SeparateFrames ? 3 : 1));
+            REQUIRE(mock::spi.rejected == 0);
+        }
+    }
+    resetSpi();
+}
+
+TEST_CASE("Apa102 separate vs. contiguous frame", "[!benchmark][apa102]") {
+    const int count = 150;
+    for (auto layout : { SeparateFrames, ContiguousFrame }) {
+        resetSpi(false);
+        Apa102 leds(count, 1, 2, DoubleBuffer, 1000000, layout);
+        BENCHMARK(layout == SeparateFrames ? "separate frames" : "contiguous frame") {
+            leds.show();
+            leds.wait();
+        }
+        REQUIRE(mock::spi.rejected == 0);
+    }
+    resetSpi();
+}
+
+namespace {
+
+// Light output of a converted channel, in the 16-bit scale of the input
+double hdrOutput(const Apa102::ApaRgb& c, uint8_t pwm) { return (c.v & 0x1F) * pwm * 65535.0 / (31 * 255); }
+
+std::vector<Rgb16> hdrSamples() {
+    std::vector<Rgb16> ret;
+    for (uint32_t r = 0; r <= 65535; r += 997)
+        for (uint32_t g = 0; g <= 65535; g += 4099)
+            ret.emplace_back(r, g, (r * 7 + g) & 0xFFFF);
+    for (uint32_t v = 0; v <= 2048; v++)
+        ret.emplace_back(v, v / 2, v / 3);
+    return ret;
+}
+
+} // namespace
+
+TEST_CASE("Apa102 HDR conversion is within rounding error of ideal", "[apa102][hdr]") {
+    auto src = hdrSamples();
+    std::vector<Apa102::ApaRgb> dest(src.size());
+    Apa102::convertHdr(src.data(), dest.data(), src.size());
+
+    for (size_t i = 0; i != src.size(); i++) {
+        const auto& c = dest[i];
+        const int brightness = c.v & 0x1F;
+        CAPTURE(src[i].r, src[i].g, src[i].b, brightness, int(c.r), int(c.g), int(c.b));
+        REQUIRE((c.v & 0xE0) == 0xE0);
+        REQUIRE(brightness >= 1);
+
+        // Lowest brightness which fits the brightest channel
+        const int max = std::max(src[i].r, std::max(src[i].g, src[i].b));
+        REQUIRE(brightness == std::max(1, int(std::ceil(max * 31.0 / 65535))));
+
+        // Half a PWM step of rounding, plus a bit for the fixed point scale
+        const double tolerance = 0.55 * brightness * 65535.0 / (31 * 255);
+        REQUIRE(std::abs(hdrOutput(c, c.r) - src[i].r) <= tolerance);
+        REQUIRE(std::abs(hdrOutput(c, c.g) - src[i].g) <= tolerance);
+        REQUIRE(std::abs(hdrOutput(c, c.b) - src[i].b) <= tolerance);
+    }
+}
+
+TEST_CASE("Apa102 HDR is more precise than 8 bits for dark colors", "[apa102][hdr]") {
+    double hdrError = 0, plainError = 0;
+    for (uint32_t v = 0; v <= 4096; v++) {
+        Rgb16 src(v, v, v);
+        Apa102::ApaRgb hdr;
+        Apa102::convertHdr(&src, &hdr, 1);
+
+        Apa102::ApaRgb plain;
+        plain = Rgb((v + 128) / 257, 0, 0);
+        hdrError += std::abs(hdrOutput(hdr, hdr.r) - v);
+        plainError += std::abs(hdrOutput(plain, plain.r) - v);
+    }
+    CAPTURE(hdrError, plainError);
+    REQUIRE(hdrError * 10 < plainError);
+}
+
+TEST_CASE("Apa102 HDR conversion", "[!benchmark][apa102][hdr]") {
+    const int count = 1000;
+    std::vector<Rgb16> src;
+    std::vector<Rgb> src8;
+    for (int i = 0; i != count; i++) {
+        src.emplace_back(i * 65, i * 13, 65535 - i * 50);
+        src8.emplace_back(i, i * 3, 255 - i);
+    }
+    std::vector<Apa102::ApaRgb> dest(count);
+
+    BENCHMARK("8-bit Rgb -> ApaRgb, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            dest[i] = src8[i];
+    }
+    BENCHMARK("HDR Rgb16 -> ApaRgb, 1000 LEDs") { Apa102::convertHdr(src.data(), dest.data(), count); }
+    REQUIRE(dest[500].r != 0);
+}
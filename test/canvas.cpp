@@ -0,0 +1,83 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <driver/spi_test_helpers.h>
+#include <vector>
+
+static_assert(IsLedOutput<Canvas>::value, "a canvas can be used as a strip");
+
+namespace {
+
+Rgb pattern(int idx) { return Rgb(idx, idx >> 8, 255 - (idx & 0xFF)); }
+
+} // namespace
+
+TEST_CASE("Canvas scatters its pixels to the attached strips", "[canvas]") {
+    resetSpi(false);
+    Apa102 first(30, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST);
+    Apa102 second(20, 3, 4, SingleBuffer, 1000000, ContiguousFrame, SPI3_HOST, 5);
+    LDP8806 third(10, 3, 4, SingleBuffer, 2000000, SPI3_HOST, 8);
+
+    Canvas canvas(60);
+    REQUIRE(canvas.attach(first));
+    REQUIRE(canvas.attach(second, true));
+    REQUIRE(canvas.attach(third, { 50, 10 }));
+    REQUIRE(canvas.outputCount() == 3);
+
+    for (int i = 0; i != canvas.size(); i++)
+        canvas[i] = pattern(i);
+    REQUIRE(canvas.show() == ESP_OK);
+    REQUIRE(mock::spi.transactions == 3);
+    REQUIRE(canvas.ready());
+
+    auto expect = [](auto pixel, int idx) {
+        decltype(pixel) expected;
+        expected = pattern(idx);
+        return pixel.r == expected.r && pixel.g == expected.g && pixel.b == expected.b;
+    };
+    for (int i = 0; i != 30; i++)
+        REQUIRE(expect(first[i], i));
+    for (int i = 0; i != 20; i++)
+        REQUIRE(expect(second[i], 49 - i));
+    for (int i = 0; i != 10; i++)
+        REQUIRE(expect(third[i], 50 + i));
+    resetSpi(false);
+}
+
+TEST_CASE("Canvas rejects mappings out of its range", "[canvas]") {
+    resetSpi(false);
+    Apa102 strip(30, 1, 2);
+    Canvas canvas(20);
+    REQUIRE_FALSE(canvas.attach(strip));
+    REQUIRE_FALSE(canvas.attach(strip, { 0, 31 }));
+    REQUIRE(canvas.attach(strip, { 0, 10, 2 }));
+    REQUIRE_FALSE(canvas.attach(strip, { 0, 11, 2 }));
+    REQUIRE(canvas.outputCount() == 1);
+}
+
+TEST_CASE("Canvas mapped writes vs. direct strip access", "[!benchmark][canvas]") {
+    resetSpi(false);
+    const int count = 300;
+    Apa102 first(count, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST);
+    Apa102 second(count, 3, 4, SingleBuffer, 1000000, ContiguousFrame, SPI3_HOST);
+    Canvas canvas(2 * count);
+    canvas.attach(first);
+    canvas.attach(second, true);
+
+    BENCHMARK("direct, 2x300 LEDs") {
+        for (int i = 0; i != count; i++) {
+            first[i] = pattern(i);
+            second[count - 1 - i] = pattern(count + i);
+        }
+        first.show();
+        second.show();
+        first.wait();
+        second.wait();
+    }
+    BENCHMARK("canvas, 2x300 LEDs") {
+        for (int i = 0; i != canvas.size(); i++)
+            canvas[i] = pattern(i);
+        canvas.show();
+        canvas.wait();
+    }
+    REQUIRE(mock::spi.rejected == 0);
+}
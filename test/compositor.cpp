@@ -0,0 +1,95 @@
+#include <Compositor.h>
+#include <catch.hpp>
+#include <vector>
+
+namespace {
+
+Rgb layerPixel(int layer, int idx) { return Rgb((idx * 7 + layer * 40) & 0xFF, (idx * 3 + layer * 90) & 0xFF, (255 - idx - layer * 30) & 0xFF); }
+
+void fillLayers(Compositor& comp) {
+    for (int l = 0; l != comp.layerCount(); l++) {
+        auto layer = comp.layer(l);
+        for (int i = 0; i != comp.size(); i++)
+            layer[i] = layerPixel(l, i);
+    }
+}
+
+// One full pass per layer, the way it would be done without the compositor
+void flattenPerLayer(Compositor& comp, std::vector<Rgb>& out) {
+    std::fill(out.begin(), out.end(), Rgb(0, 0, 0));
+    for (int l = 0; l != comp.layerCount(); l++)
+        Compositor::blend(out.data(), comp.layer(l).data(), comp.size(), comp.mode(l), comp.opacity(l));
+}
+
+} // namespace
+
+TEST_CASE("Blend modes", "[compositor]") {
+    const Rgb base(100, 200, 50);
+    const Rgb top(200, 100, 0);
+    auto blended = [&](BlendMode mode, uint8_t opacity = 255, uint8_t alpha = 255) {
+        Rgb dest = base;
+        Rgb src = top;
+        src.a = alpha;
+        Compositor::blend(&dest, &src, 1, mode, opacity);
+        return dest;
+    };
+
+    REQUIRE(blended(BlendNormal) == Rgb(200, 100, 0));
+    REQUIRE(blended(BlendAdd) == Rgb(255, 255, 50));
+    REQUIRE(blended(BlendMax) == Rgb(200, 200, 50));
+    REQUIRE(blended(BlendMultiply) == Rgb(78, 78, 0));
+    REQUIRE(blended(BlendScreen) == Rgb(222, 222, 50));
+
+    REQUIRE(blended(BlendNormal, 0) == base);
+    REQUIRE(blended(BlendNormal, 255, 0) == base);
+    REQUIRE(blended(BlendNormal, 128) == Rgb(150, 150, 25));
+    REQUIRE(blended(BlendNormal, 255, 128) == Rgb(150, 150, 25));
+}
+
+TEST_CASE("Single pass flatten equals one pass per layer", "[compositor]") {
+    const int count = 150; // not a multiple of the chunk size
+    Compositor comp(count);
+    const BlendMode modes[] = { BlendNormal, BlendAdd, BlendScreen, BlendMultiply, BlendMax, BlendNormal };
+    for (int l = 0; l != 6; l++)
+        REQUIRE(comp.addLayer(modes[l], 255 - l * 40) == l);
+    fillLayers(comp);
+
+    std::vector<Rgb> expected(count), flattened(count, Rgb(1, 2, 3));
+    flattenPerLayer(comp, expected);
+    LedSpan<Rgb> out(flattened.data(), count);
+    comp.flatten(out);
+    REQUIRE(flattened == expected);
+}
+
+TEST_CASE("Layers limit and defaults", "[compositor]") {
+    Compositor comp(10);
+    for (int i = 0; i != Compositor::MAX_LAYERS; i++)
+        REQUIRE(comp.addLayer() == i);
+    REQUIRE(comp.addLayer() == -1);
+
+    std::vector<Rgb> out(10, Rgb(9, 9, 9));
+    comp.flatten(out);
+    REQUIRE(out[5] == Rgb(0, 0, 0));
+
+    // The top layer, the layers below are opaque black
+    comp.layer(7)[5] = Rgb(10, 20, 30);
+    comp.setMode(7, BlendAdd);
+    comp.flatten(out);
+    REQUIRE(out[5] == Rgb(10, 20, 30));
+    REQUIRE(out[4] == Rgb(0, 0, 0));
+}
+
+TEST_CASE("Compositing 2 to 8 layers", "[!benchmark][compositor]") {
+    const int count = 1000;
+    std::vector<Rgb> out(count);
+    for (int layers : { 2, 4, 8 }) {
+        Compositor comp(count);
+        for (int l = 0; l != layers; l++)
+            comp.addLayer(BlendMode(l % 5), 200);
+        fillLayers(comp);
+
+        BENCHMARK(std::to_string(layers) + " layers, pass per layer, 1000 LEDs") { flattenPerLayer(comp, out); }
+        BENCHMARK(std::to_string(layers) + " layers, single pass, 1000 LEDs") { comp.flatten(out); }
+    }
+    REQUIRE(out[0].a == 255);
+}
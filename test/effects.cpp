@@ -0,0 +1,152 @@
+#include <Effects.h>
+#include <FixedMath.h>
+#include <Noise.h>
+#include <catch.hpp>
+#include <vector>
+
+using namespace smartleds;
+
+namespace {
+
+uint32_t fakeNow = 0;
+uint32_t fakeClock() { return fakeNow; }
+
+// Takes a given (fake) time to render
+struct CostlyEffect : public Effect {
+    uint32_t costUs;
+    Rgb color;
+    int renders = 0;
+
+    CostlyEffect(uint32_t costUs, Rgb color)
+        : costUs(costUs)
+        , color(color) {}
+
+    void render(LedSpan<Rgb> leds, uint32_t) override {
+        for (auto& p : leds)
+            p = color;
+        fakeNow += costUs;
+        renders++;
+    }
+};
+
+struct Wave : public Effect {
+    void render(LedSpan<Rgb> leds, uint32_t timeMs) override {
+        for (int i = 0; i != leds.size(); i++)
+            leds[i] = Rgb(sin8(i * 8 + beat8(60, timeMs)), 0, 0);
+    }
+    const char* name() const override { return "wave"; }
+};
+
+struct Plasma : public Effect {
+    void render(LedSpan<Rgb> leds, uint32_t timeMs) override {
+        for (int i = 0; i != leds.size(); i++)
+            leds[i] = Rgb(noise8(i << 12, 0, timeMs << 6), 0, 0);
+    }
+};
+
+} // namespace
+
+TEST_CASE("Effect stats", "[effects]") {
+    EffectStats stats;
+    REQUIRE(stats.p99Us() == 0);
+    for (uint32_t i = 1; i <= 200; i++)
+        stats.add(i);
+    REQUIRE(stats.frames() == 200);
+    REQUIRE(stats.maxUs() == 200);
+    REQUIRE(stats.lastUs() == 200);
+    REQUIRE(stats.averageUs() == 100);
+    // The window holds 73..200, 99 % of them are <= 199
+    REQUIRE(stats.p99Us() == 199);
+
+    stats.reset();
+    for (int i = 0; i != 99; i++)
+        stats.add(10);
+    stats.add(1000);
+    REQUIRE(stats.p99Us() == 10);
+    stats.add(1000);
+    REQUIRE(stats.p99Us() == 1000);
+}
+
+TEST_CASE("Engine falls back after consecutive overruns", "[effects]") {
+    std::vector<Rgb> pixels(10);
+    LedSpan<Rgb> leds(pixels.data(), pixels.size());
+    CostlyEffect slow(5000, Rgb(255, 0, 0)), cheap(100, Rgb(0, 255, 0));
+    EffectEngine engine(leds, 4000, fakeClock);
+    REQUIRE(engine.add(slow, &cheap) == 0);
+    REQUIRE(engine.selected() == 0);
+
+    REQUIRE(engine.renderFrame(0) == 5000);
+    REQUIRE(engine.renderFrame(16) == 5000);
+    REQUIRE_FALSE(engine.degraded(0));
+    engine.renderFrame(32);
+    REQUIRE(engine.degraded(0));
+    REQUIRE(pixels[0] == Rgb(255, 0, 0));
+
+    engine.renderFrame(48);
+    REQUIRE(pixels[0] == Rgb(0, 255, 0));
+    REQUIRE(engine.stats(0).frames() == 3);
+    REQUIRE(engine.fallbackStats(0).frames() == 1);
+    REQUIRE(engine.fallbackStats(0).maxUs() == 100);
+
+    // A single overrun is tolerated
+    engine.select(0);
+    slow.costUs = 3000;
+    engine.renderFrame(64);
+    slow.costUs = 6000;
+    engine.renderFrame(80);
+    slow.costUs = 3000;
+    engine.renderFrame(96);
+    REQUIRE_FALSE(engine.degraded(0));
+}
+
+TEST_CASE("Effects without fallback and without budget keep running", "[effects]") {
+    std::vector<Rgb> pixels(4);
+    LedSpan<Rgb> leds(pixels.data(), pixels.size());
+    CostlyEffect slow(5000, Rgb(1, 2, 3));
+    EffectEngine noFallback(leds, 1000, fakeClock);
+    noFallback.add(slow);
+    EffectEngine noBudget(leds, 0, fakeClock);
+    noBudget.add(slow);
+    for (int i = 0; i != 10; i++) {
+        noFallback.renderFrame(i);
+        noBudget.renderFrame(i);
+    }
+    REQUIRE_FALSE(noFallback.degraded(0));
+    REQUIRE_FALSE(noBudget.degraded(0));
+    REQUIRE(slow.renders == 20);
+}
+
+TEST_CASE("Host runner is deterministic", "[effects]") {
+    const int count = 32, frames = 50;
+    std::vector<Rgb> pixels(count);
+    LedSpan<Rgb> leds(pixels.data(), count);
+    Wave wave;
+    std::vector<Rgb> first(count * frames), second(count * frames);
+    auto stats = runEffect(wave, leds, frames, 20, first.data());
+    runEffect(wave, leds, frames, 20, second.data());
+    REQUIRE(stats.frames() == frames);
+    REQUIRE(first == second);
+    // Frame 25 is rendered at 500 ms, i.e. half a beat
+    REQUIRE(first[25 * count].r == sin8(128));
+}
+
+TEST_CASE("Effect render times", "[!benchmark][effects]") {
+    const int count = 1000;
+    std::vector<Rgb> pixels(count);
+    LedSpan<Rgb> leds(pixels.data(), count);
+    Wave wave;
+    Plasma plasma;
+
+    auto waveStats = runEffect(wave, leds, 200, 16);
+    auto plasmaStats = runEffect(plasma, leds, 200, 16);
+    WARN("wave: avg " << waveStats.averageUs() << " us, p99 " << waveStats.p99Us() << " us, max "
+                      << waveStats.maxUs() << " us");
+    WARN("plasma: avg " << plasmaStats.averageUs() << " us, p99 " << plasmaStats.p99Us() << " us, max "
+                        << plasmaStats.maxUs() << " us");
+
+    EffectEngine engine(leds, 20000);
+    engine.add(plasma, &wave);
+    uint32_t t = 0;
+    BENCHMARK("engine frame (plasma), 1000 LEDs") { engine.renderFrame(t += 16); }
+    REQUIRE(engine.stats(0).frames() > 0);
+}
@@ -0,0 +1,141 @@
+// Arduino.h defines it, the header must still compile
+#define PI 3.1415926535897932384626433832795
+
+#include <FixedMath.h>
+#include <LedOutput.h>
+#include <catch.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace smartleds;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+double smoothstep(double x) { return x * x * (3 - 2 * x); }
+
+} // namespace
+
+TEST_CASE("sin8 and sin16 match the floating point sine", "[fixedmath]") {
+    for (int i = 0; i != 256; i++) {
+        CAPTURE(i);
+        REQUIRE(std::abs(sin8(i) - (127.5 + 127.5 * std::sin(2 * kPi * i / 256))) <= 0.501);
+        REQUIRE(std::abs(cos8(i) - (127.5 + 127.5 * std::cos(2 * kPi * i / 256))) <= 0.501);
+    }
+
+    double maxError = 0;
+    for (int i = 0; i != 65536; i++) {
+        double error = std::abs(sin16(i) - 32767 * std::sin(2 * kPi * i / 65536));
+        maxError = std::max(maxError, error);
+    }
+    CAPTURE(maxError);
+    REQUIRE(maxError < 1.1);
+    REQUIRE(sin16(0) == 0);
+    REQUIRE(sin16(16384) == 32767);
+    REQUIRE(sin16(49152) == -32767);
+    REQUIRE(cos16(0) == 32767);
+}
+
+TEST_CASE("Triangle wave", "[fixedmath]") {
+    REQUIRE(tri8(0) == 0);
+    REQUIRE(tri8(64) == 128);
+    REQUIRE(tri8(127) == 254);
+    REQUIRE(tri8(128) == 255);
+    REQUIRE(tri8(255) == 1);
+}
+
+TEST_CASE("Scaling and interpolation", "[fixedmath]") {
+    for (int a = 0; a != 256; a++) {
+        REQUIRE(scale8(a, 255) == a);
+        REQUIRE(scale8(a, 0) == 0);
+        for (int b = 0; b < 256; b += 5) {
+            CAPTURE(a, b);
+            REQUIRE(std::abs(scale8(a, b) - a * b / 255.0) < 1);
+            REQUIRE(lerp8(a, b, 0) == a);
+            REQUIRE(lerp8(a, b, 255) == b);
+            for (int f = 0; f < 256; f += 17)
+                REQUIRE(std::abs(lerp8(a, b, f) - (a + (b - a) * f / 255.0)) < 1.5);
+        }
+    }
+    REQUIRE(lerp16(1000, 60000, 0) == 1000);
+    REQUIRE(lerp16(1000, 60000, 65535) == 60000);
+    REQUIRE(std::abs(lerp16(60000, 1000, 32768) - 30500) <= 1);
+    REQUIRE(scale16(65535, 65535) == 65535);
+
+    REQUIRE(lerp(Rgb(0, 100, 200), Rgb(200, 100, 0), 255) == Rgb(200, 100, 0));
+    REQUIRE(scale8(Rgb(200, 100, 50), 127) == Rgb(100, 50, 25));
+}
+
+TEST_CASE("Whole strip scaling", "[fixedmath]") {
+    std::vector<Rgb> pixels(10, Rgb(200, 100, 10));
+    LedSpan<Rgb> strip(pixels.data(), pixels.size());
+    nscale8(strip, 127);
+    REQUIRE(pixels[9] == Rgb(100, 50, 5));
+    fadeToBlack(strip, 255);
+    REQUIRE(pixels[0] == Rgb(0, 0, 0));
+}
+
+TEST_CASE("Easing curves match the floating point ones", "[fixedmath]") {
+    for (int i = 0; i != 256; i++) {
+        CAPTURE(i);
+        const double x = i / 255.0;
+        REQUIRE(std::abs(ease8InQuad(i) - 255 * x * x) <= 1);
+        REQUIRE(std::abs(ease8OutQuad(i) - 255 * (1 - (1 - x) * (1 - x))) <= 1);
+        const double inOut = x < 0.5 ? 2 * x * x : 1 - 2 * (1 - x) * (1 - x);
+        REQUIRE(std::abs(ease8InOutQuad(i) - 255 * inOut) <= 2);
+        REQUIRE(std::abs(ease8InOutCubic(i) - 255 * smoothstep(x)) <= 0.51);
+    }
+    REQUIRE(ease8InOutCubic(0) == 0);
+    REQUIRE(ease8InOutCubic(255) == 255);
+    REQUIRE(ease8InOutQuad(255) == 255);
+}
+
+TEST_CASE("Beat generators", "[fixedmath]") {
+    // 60 BPM is one beat per second
+    REQUIRE(beat16(60, 0) == 0);
+    REQUIRE(beat16(60, 500) == 32768);
+    REQUIRE(beat16(60, 1000) == 0);
+    REQUIRE(beat8(120, 250) == 128);
+
+    for (uint32_t t = 0; t < 5000; t += 7) {
+        CAPTURE(t);
+        auto v = beatsin8(30, 50, 200, t);
+        REQUIRE(v >= 50);
+        REQUIRE(v <= 200);
+        auto v16 = beatsin16(30, 1000, 2000, t);
+        REQUIRE(v16 >= 1000);
+        REQUIRE(v16 <= 2000);
+    }
+    REQUIRE(beatsin8(60, 0, 255, 250) == 255);
+}
+
+TEST_CASE("Fixed point vs. float math", "[!benchmark][fixedmath]") {
+    const int count = 1000;
+    std::vector<Rgb> pixels(count, Rgb(200, 150, 100));
+    LedSpan<Rgb> strip(pixels.data(), pixels.size());
+    uint32_t sink = 0;
+
+    BENCHMARK("sinf, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            pixels[i].r = uint8_t(127.5f + 127.5f * sinf(i * 0.05f));
+    }
+    BENCHMARK("sin8, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            pixels[i].r = sin8(i * 2);
+    }
+    BENCHMARK("sin16, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            sink += sin16(i * 521);
+    }
+    BENCHMARK("float brightness, 1000 LEDs") {
+        const float f = 0.9f;
+        for (auto& p : pixels) {
+            p.r = p.r * f;
+            p.g = p.g * f;
+            p.b = p.b * f;
+        }
+    }
+    BENCHMARK("nscale8, 1000 LEDs") { nscale8(strip, 230); }
+    REQUIRE(sink != 1);
+}
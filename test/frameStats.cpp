@@ -0,0 +1,125 @@
+#include <FrameStats.h>
+#include <catch.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+void requireSame(const FrameStats& a, const FrameStats& b) {
+    REQUIRE(a.sums().r == b.sums().r);
+    REQUIRE(a.sums().g == b.sums().g);
+    REQUIRE(a.sums().b == b.sums().b);
+    REQUIRE(a.lit() == b.lit());
+    for (int i = 0; i != FrameStats::BUCKETS; i++)
+        REQUIRE(a.histogram(i) == b.histogram(i));
+    REQUIRE(a.maxLevel() == b.maxLevel());
+}
+
+} // namespace
+
+TEST_CASE("Tracked writes keep the stats equal to a full scan", "[framestats]") {
+    const int count = 300;
+    std::vector<Rgb> frame(count, Rgb(0, 0, 0));
+    FrameStats stats;
+    stats.scan(frame.data(), count);
+    REQUIRE(stats.black());
+    REQUIRE(stats.maxLevel() == 0);
+
+    std::mt19937 gen(17);
+    std::uniform_int_distribution<int> idx(0, count - 1), chan(0, 255);
+    for (int round = 0; round != 50; round++) {
+        for (int i = 0; i != 100; i++) {
+            TrackedPixel p(frame[idx(gen)], stats);
+            switch (i % 4) {
+            case 0:
+                p = Rgb(chan(gen), chan(gen), chan(gen));
+                break;
+            case 1:
+                p = Rgb(0, 0, 0);
+                break;
+            case 2:
+                p += Rgb(chan(gen) / 4, 0, chan(gen) / 4);
+                break;
+            case 3:
+                p = Hsv(chan(gen), 255, chan(gen));
+                break;
+            }
+        }
+        FrameStats reference;
+        reference.scan(frame.data(), count);
+        requireSame(stats, reference);
+    }
+}
+
+TEST_CASE("Lit count, histogram and max level", "[framestats]") {
+    std::vector<Rgb> frame(10, Rgb(0, 0, 0));
+    FrameStats stats;
+    stats.scan(frame.data(), frame.size());
+
+    TrackedPixel(frame[3], stats) = Rgb(0, 0, 1);
+    REQUIRE(stats.lit() == 1);
+    REQUIRE_FALSE(stats.black());
+    REQUIRE(stats.maxLevel() == 15);
+
+    TrackedPixel(frame[4], stats) = Rgb(200, 10, 10);
+    REQUIRE(stats.lit() == 2);
+    REQUIRE(stats.histogram(200 / 16) == 1);
+    REQUIRE(stats.maxLevel() == 207);
+    REQUIRE(stats.maxLevel() >= 200);
+
+    // Copying between tracked pixels copies the value
+    TrackedPixel(frame[5], stats) = TrackedPixel(frame[4], stats);
+    REQUIRE(frame[5] == frame[4]);
+    REQUIRE(stats.histogram(200 / 16) == 2);
+
+    TrackedPixel(frame[4], stats) = Rgb(0, 0, 0);
+    TrackedPixel(frame[5], stats) = Rgb(0, 0, 0);
+    REQUIRE(stats.maxLevel() == 15);
+    TrackedPixel(frame[3], stats) -= Rgb(0, 0, 1);
+    REQUIRE(stats.black());
+    REQUIRE(stats.sums().b == 0);
+    REQUIRE(stats.histogram(0) == 10);
+}
+
+TEST_CASE("Tracked writes vs. scanning the frame", "[!benchmark][framestats]") {
+    const int count = 1000;
+    std::vector<Rgb> frame(count);
+    FrameStats stats;
+    stats.scan(frame.data(), count);
+    uint8_t t = 0;
+    uint32_t total = 0;
+
+    BENCHMARK("plain writes + scan, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            frame[i] = Rgb(i + t, t, 3 * i);
+        const auto sums = channelSums(frame.data(), count);
+        bool black = true;
+        for (const auto& p : frame)
+            black &= !(p.r | p.g | p.b);
+        total += sums.r + black;
+        t++;
+    }
+    BENCHMARK("tracked writes, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            TrackedPixel(frame[i], stats) = Rgb(i + t, t, 3 * i);
+        total += stats.sums().r + stats.black();
+        t++;
+    }
+    BENCHMARK("tracked writes, 50 of 1000 LEDs") {
+        for (int i = 0; i != 50; i++)
+            TrackedPixel(frame[i * 20], stats) = Rgb(i + t, t, 3 * i);
+        total += stats.sums().r + stats.black();
+        t++;
+    }
+    BENCHMARK("plain writes of 50 + scan, 1000 LEDs") {
+        for (int i = 0; i != 50; i++)
+            frame[i * 20] = Rgb(i + t, t, 3 * i);
+        const auto sums = channelSums(frame.data(), count);
+        bool black = true;
+        for (const auto& p : frame)
+            black &= !(p.r | p.g | p.b);
+        total += sums.r + black;
+        t++;
+    }
+    REQUIRE(total != 1);
+}
@@ -0,0 +1,119 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <driver/spi_test_helpers.h>
+#include <cmath>
+#include <vector>
+
+using Grb = LDP8806::LDP8806_GRB;
+
+TEST_CASE("LDP8806 linear conversion uses the full 7-bit range", "[ldp8806]") {
+    const auto& lut = LDP8806::LINEAR_LUT.value;
+    REQUIRE(lut[0] == 0x80);
+    REQUIRE(lut[255] == (0x80 | 127));
+    for (int c = 0; c != 256; c++) {
+        CAPTURE(c);
+        REQUIRE((lut[c] & 0x80) != 0);
+        REQUIRE(std::abs((lut[c] & 0x7F) - c * 127.0 / 255) <= 0.5);
+        if (c > 0)
+            REQUIRE(lut[c] >= lut[c - 1]);
+    }
+}
+
+TEST_CASE("LDP8806 gamma conversion", "[ldp8806]") {
+    const auto& lut = LDP8806::GAMMA_LUT.value;
+    REQUIRE(lut[0] == 0x80);
+    REQUIRE(lut[255] == (0x80 | 127));
+    for (int c = 0; c != 256; c++) {
+        CAPTURE(c);
+        REQUIRE(std::abs((lut[c] & 0x7F) - std::pow(c / 255.0, 3) * 127) <= 0.5);
+        if (c > 0)
+            REQUIRE(lut[c] >= lut[c - 1]);
+    }
+}
+
+TEST_CASE("LDP8806 batch conversion matches assignment", "[ldp8806]") {
+    std::vector<Rgb> src;
+    for (int i = 0; i != 256; i++)
+        src.emplace_back(i, 255 - i, (i * 7) & 0xFF);
+    std::vector<Grb> batch(src.size()), single(src.size());
+    LDP8806::convert(src.data(), batch.data(), src.size());
+    for (size_t i = 0; i != src.size(); i++) {
+        single[i] = src[i];
+        REQUIRE(batch[i].g == single[i].g);
+        REQUIRE(batch[i].r == single[i].r);
+        REQUIRE(batch[i].b == single[i].b);
+    }
+}
+
+TEST_CASE("LDP8806 shows a user Rgb buffer", "[ldp8806]") {
+    resetSpi();
+    std::vector<Rgb> src { Rgb(255, 0, 0), Rgb(0, 255, 0), Rgb(0, 0, 255) };
+    LDP8806 leds(src.size(), 1, 2);
+    leds.show(src.data());
+    leds.wait();
+
+    std::vector<uint8_t> expected { 0x80, 0xFF, 0x80, 0xFF, 0x80, 0x80, 0x80, 0x80, 0xFF, 0, 0, 0 };
+    REQUIRE(mock::spi.wire == expected);
+}
+
+TEST_CASE("LDP8806 sends pixels and latch in one transaction", "[ldp8806]") {
+    for (int count : { 1, 31, 32, 33, 600, 601, 5000 }) {
+        resetSpi();
+        LDP8806 leds(count, 1, 2, DoubleBuffer);
+        for (int i = 0; i != count; i++)
+            leds[i] = Rgb(i, i >> 8, 255);
+        leds.show();
+        leds.wait();
+
+        std::vector<uint8_t> expected;
+        for (int i = 0; i != count; i++) {
+            const auto& lut = LDP8806::LINEAR_LUT.value;
+            expected.insert(expected.end(), { lut[(i >> 8) & 0xFF], lut[i & 0xFF], lut[255] });
+        }
+        // 3 zero bytes for every started 32 LEDs
+        expected.resize(expected.size() + 3 * ((count + 31) / 32), 0);
+
+        CAPTURE(count);
+        REQUIRE(mock::spi.transactions == 1);
+        REQUIRE(mock::spi.rejected == 0);
+        REQUIRE(mock::spi.wire == expected);
+    }
+}
+
+TEST_CASE("LDP8806 latch stays zero after reconfigure", "[ldp8806][reconfigure]") {
+    resetSpi();
+    LDP8806 leds(64, 1, 2);
+    REQUIRE(leds.reconfigure(10, 2000000) == ESP_OK);
+    leds.show();
+    leds.wait();
+    REQUIRE(mock::spi.wire.size() == 10 * 3 + 3);
+    REQUIRE(mock::spi.wire[30] == 0);
+    REQUIRE(mock::spi.wire[32] == 0);
+
+    REQUIRE(leds.reconfigure(40, 2000000) == ESP_OK);
+    mock::spi.reset();
+    leds.show();
+    leds.wait();
+    REQUIRE(mock::spi.wire.size() == 40 * 3 + 6);
+    REQUIRE(mock::spi.wire[39 * 3] == 0x80);
+    REQUIRE(mock::spi.wire[40 * 3 + 5] == 0);
+}
+
+TEST_CASE("LDP8806 conversion", "[!benchmark][ldp8806]") {
+    const int count = 1000;
+    std::vector<Rgb> src;
+    for (int i = 0; i != count; i++)
+        src.emplace_back(i, i * 3, 255 - i);
+    std::vector<Grb> dest(count);
+
+    BENCHMARK("division per channel, 1000 LEDs") {
+        for (int i = 0; i != count; i++) {
+            dest[i].r = (src[i].r * 127 / 256) | 0x80;
+            dest[i].g = (src[i].g * 127 / 256) | 0x80;
+            dest[i].b = (src[i].b * 127 / 256) | 0x80;
+        }
+    }
+    BENCHMARK("LUT batch, 1000 LEDs") { LDP8806::convert(src.data(), dest.data(), count); }
+    BENCHMARK("LUT batch with gamma, 1000 LEDs") { LDP8806::convert(src.data(), dest.data(), count, true); }
+    REQUIRE(dest[10].g != 0);
+}
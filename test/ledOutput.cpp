@@ -0,0 +1,94 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <driver/spi_test_helpers.h>
+#include <vector>
+
+static_assert(IsLedOutput<Apa102>::value, "Apa102 is an LED output");
+static_assert(IsLedOutput<LDP8806>::value, "LDP8806 is an LED output");
+static_assert(IsLedOutput<SmartLed>::value, "SmartLed is an LED output");
+static_assert(!IsLedOutput<LedSpan<Rgb>>::value, "a span can't be shown");
+
+namespace {
+
+// Written once, works on any strip or span
+template <class Leds>
+void renderGradient(Leds& leds) {
+    for (int i = 0; i != leds.size(); i++)
+        leds[i] = Rgb(i, 255 - i, 2 * i);
+}
+
+} // namespace
+
+TEST_CASE("The same render code drives every SPI strip", "[ledoutput]") {
+    resetSpi();
+    const int count = 50;
+    Apa102 apa(count, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST);
+    LDP8806 ldp(count, 3, 4, SingleBuffer, 2000000, SPI3_HOST);
+
+    renderGradient(apa);
+    renderGradient(ldp);
+    REQUIRE(showAll(apa, ldp) == ESP_OK);
+    REQUIRE(mock::spi.transactions == 2);
+    REQUIRE(apa.ready());
+    REQUIRE(ldp.ready());
+
+    for (int i = 0; i != count; i++) {
+        Apa102::ApaRgb apaExpected;
+        apaExpected = Rgb(i, 255 - i, 2 * i);
+        REQUIRE(apa[i].v == apaExpected.v);
+        REQUIRE(apa[i].r == apaExpected.r);
+
+        LDP8806::LDP8806_GRB ldpExpected;
+        ldpExpected = Rgb(i, 255 - i, 2 * i);
+        REQUIRE(ldp[i].g == ldpExpected.g);
+        REQUIRE(ldp[i].b == ldpExpected.b);
+    }
+    resetSpi();
+}
+
+TEST_CASE("Spans view a part of the strip", "[ledoutput]") {
+    resetSpi();
+    Apa102 apa(20, 1, 2);
+    auto all = ledSpan(apa);
+    REQUIRE(all.size() == 20);
+    REQUIRE(all.begin() == apa.begin());
+
+    auto part = all.subspan(5, 10);
+    renderGradient(part);
+    REQUIRE(apa[4].r == 0);
+    REQUIRE(apa[5].g == 255);
+    REQUIRE(apa[14].b == 18);
+    REQUIRE(apa[15].g == 0);
+}
+
+TEST_CASE("Show tokens track the SPI transfer", "[ledoutput]") {
+    resetSpi();
+    LDP8806 ldp(10, 1, 2);
+
+    mock::spi.stalled = true;
+    auto token = ldp.showAsync();
+    REQUIRE(token.error() == ESP_OK);
+    REQUIRE_FALSE(token.ready());
+    REQUIRE_FALSE(token.wait(0));
+
+    mock::spi.stalled = false;
+    REQUIRE(ShowToken::waitAll({ token }));
+    REQUIRE(ldp.ready());
+    resetSpi();
+}
+
+TEST_CASE("Generic vs. native rendering", "[!benchmark][ledoutput]") {
+    resetSpi(false);
+    const int count = 300;
+    Apa102 apa(count, 1, 2);
+
+    BENCHMARK("native Apa102 loop, 300 LEDs") {
+        for (int i = 0; i != count; i++)
+            apa[i] = Rgb(i, 255 - i, 2 * i);
+    }
+    BENCHMARK("LedSpan loop, 300 LEDs") {
+        auto span = ledSpan(apa);
+        renderGradient(span);
+    }
+    REQUIRE(apa[100].r == 100);
+}
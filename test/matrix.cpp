@@ -0,0 +1,122 @@
+#include <SmartLeds.h>
+#include <algorithm>
+#include <catch.hpp>
+#include <vector>
+
+namespace {
+
+// Every strip index must be hit exactly once
+bool isPermutation(const MatrixMap& map) {
+    std::vector<int> hits(map.size());
+    for (int y = 0; y != map.height(); y++)
+        for (int x = 0; x != map.width(); x++)
+            hits[map(x, y)]++;
+    return std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; });
+}
+
+Rgb pattern(int idx) { return Rgb(idx, idx >> 8, 3 * idx); }
+
+} // namespace
+
+TEST_CASE("Plain and serpentine rows", "[matrix]") {
+    MatrixMap rows({ 4, 3, false });
+    REQUIRE(rows(0, 0) == 0);
+    REQUIRE(rows(3, 0) == 3);
+    REQUIRE(rows(0, 1) == 4);
+    REQUIRE(rows(3, 2) == 11);
+
+    MatrixMap snake({ 4, 3 });
+    REQUIRE(snake(0, 0) == 0);
+    REQUIRE(snake(3, 0) == 3);
+    REQUIRE(snake(3, 1) == 4);
+    REQUIRE(snake(0, 1) == 7);
+    REQUIRE(snake(0, 2) == 8);
+    REQUIRE(isPermutation(rows));
+    REQUIRE(isPermutation(snake));
+}
+
+TEST_CASE("Tiled panels are chained row by row", "[matrix]") {
+    // 2x2 panels of 4x2 pixels, the second row of panels runs backwards
+    MatrixLayout layout { 8, 4, true, 4, 2, true };
+    MatrixMap map(layout);
+    REQUIRE(map(0, 0) == 0);
+    REQUIRE(map(4, 0) == 8);
+    REQUIRE(map(7, 1) == 12);
+    // Panel (1, 1) is the third one, panel (0, 1) the fourth
+    REQUIRE(map(4, 2) == 16);
+    REQUIRE(map(0, 2) == 24);
+    REQUIRE(map(0, 3) == 31);
+    REQUIRE(isPermutation(map));
+}
+
+TEST_CASE("Rotated layouts", "[matrix]") {
+    const MatrixRotation rotations[] = { Rotate0, Rotate90, Rotate180, Rotate270 };
+    for (auto rotation : rotations) {
+        MatrixLayout layout { 6, 4, true, 0, 0, false, rotation };
+        MatrixMap map(layout);
+        CAPTURE(int(rotation));
+        REQUIRE(map.width() == (rotation == Rotate90 || rotation == Rotate270 ? 4 : 6));
+        REQUIRE(map.width() * map.height() == 24);
+        REQUIRE(isPermutation(map));
+    }
+
+    MatrixMap r90({ 6, 4, false, 0, 0, false, Rotate90 });
+    // The first strip pixel is the physical top left corner, which is now top right
+    REQUIRE(r90(3, 0) == 0);
+    REQUIRE(r90(0, 0) == 18);
+    MatrixMap r180({ 6, 4, false, 0, 0, false, Rotate180 });
+    REQUIRE(r180(5, 3) == 0);
+    MatrixMap r270({ 6, 4, false, 0, 0, false, Rotate270 });
+    REQUIRE(r270(0, 5) == 0);
+}
+
+TEST_CASE("Remap matches per-pixel writes", "[matrix]") {
+    MatrixMap map({ 16, 16, true, 8, 8, true, Rotate90 });
+    std::vector<Rgb> frame(map.size());
+    for (int i = 0; i != map.size(); i++)
+        frame[i] = pattern(i);
+
+    std::vector<Rgb> perPixel(map.size()), remapped(map.size());
+    for (int y = 0; y != map.height(); y++)
+        for (int x = 0; x != map.width(); x++)
+            perPixel[map(x, y)] = frame[y * map.width() + x];
+
+    LedSpan<Rgb> strip(remapped.data(), remapped.size());
+    map.remap(frame.data(), strip);
+    REQUIRE(perPixel == remapped);
+}
+
+TEST_CASE("Layouts must be tiled exactly by the panels", "[matrix]") {
+    REQUIRE(MatrixLayout { 8, 4 }.valid());
+    REQUIRE(MatrixLayout { 8, 4, true, 4, 2 }.valid());
+    REQUIRE(MatrixLayout { 8, 4, true, 8, 0 }.valid());
+    REQUIRE(MatrixLayout { 256, 256 }.valid());
+
+    REQUIRE_FALSE(MatrixLayout { 8, 4, true, 3, 2 }.valid());
+    REQUIRE_FALSE(MatrixLayout { 8, 4, true, 4, 3 }.valid());
+    REQUIRE_FALSE(MatrixLayout { 8, 4, true, 16, 4 }.valid());
+    REQUIRE_FALSE(MatrixLayout { 0, 4 }.valid());
+    REQUIRE_FALSE(MatrixLayout { 256, 257 }.valid());
+}
+
+TEST_CASE("Matrix mapping", "[!benchmark][matrix]") {
+    MatrixLayout layout { 32, 32, true, 16, 16, true, Rotate90 };
+    MatrixMap map(layout);
+    std::vector<Rgb> frame(map.size()), strip(map.size());
+    for (int i = 0; i != map.size(); i++)
+        frame[i] = pattern(i);
+    LedSpan<Rgb> leds(strip.data(), strip.size());
+
+    BENCHMARK("computed index per pixel, 32x32") {
+        for (int y = 0; y != map.height(); y++)
+            for (int x = 0; x != map.width(); x++)
+                strip[layout.index(x, y)] = frame[y * map.width() + x];
+    }
+    BENCHMARK("LUT index per pixel, 32x32") {
+        for (int y = 0; y != map.height(); y++)
+            for (int x = 0; x != map.width(); x++)
+                strip[map(x, y)] = frame[y * map.width() + x];
+    }
+    BENCHMARK("remap pass, 32x32") { map.remap(frame.data(), leds); }
+    REQUIRE(strip[map(5, 5)] == frame[5 * map.width() + 5]);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+// Simulated legacy (IDF 4) RMT driver. rmt_write_sample() runs the translator the way the
+// driver's ISR would, half of the channel memory at a time, and logs the resulting symbols
+// in mock::rmt. Frames complete immediately (the TX end callback runs from the write)
+// unless mock::rmt.stalled is set.
+
+#include "driver/gpio.h"
+#include "esp_system.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL 64
+
+typedef enum {
+    RMT_CHANNEL_0,
+    RMT_CHANNEL_MAX = 8,
+} rmt_channel_t;
+
+typedef enum {
+    RMT_MODE_TX = 0,
+    RMT_MODE_RX,
+} rmt_mode_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef struct {
+    rmt_mode_t rmt_mode;
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+    uint32_t flags;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+    { RMT_MODE_TX, channel_id, gpio, 80, 1, 0 }
+
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void* arg);
+typedef void (*sample_to_rmt_t)(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num,
+    size_t* translated_size, size_t* item_num);
+
+typedef struct {
+    rmt_tx_end_fn_t function;
+    void* arg;
+} rmt_tx_end_callback_t;
+
+namespace mock {
+
+struct RmtChannel {
+    bool configured = false;
+    bool installed = false;
+    bool busy = false;
+    sample_to_rmt_t translator = nullptr;
+    void* context = nullptr;
+    // Symbols of the last frame
+    std::vector<uint32_t> wire;
+};
+
+struct RmtState {
+    RmtChannel channels[RMT_CHANNEL_MAX];
+    rmt_tx_end_callback_t txEnd = {};
+    // Channel being translated, the driver finds the context through it
+    int translating = -1;
+
+    // Frames started since the last reset()
+    size_t frames = 0;
+
+    // While set, frames are not finished until finish() is called
+    bool stalled = false;
+
+    void reset() {
+        frames = 0;
+        stalled = false;
+        for (auto& c : channels)
+            c.wire.clear();
+    }
+
+    void finish(int channel) {
+        if (!channels[channel].busy)
+            return;
+        channels[channel].busy = false;
+        if (txEnd.function)
+            txEnd.function((rmt_channel_t)channel, txEnd.arg);
+    }
+
+    void started(int channel) {
+        frames++;
+        channels[channel].busy = true;
+        if (!stalled)
+            finish(channel);
+    }
+};
+
+inline RmtState rmt;
+
+} // namespace mock
+
+inline esp_err_t rmt_config(const rmt_config_t* config) {
+    if (config->channel >= RMT_CHANNEL_MAX)
+        return ESP_ERR_INVALID_ARG;
+    mock::rmt.channels[config->channel].configured = true;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_install(rmt_channel_t channel, size_t, int) {
+    auto& c = mock::rmt.channels[channel];
+    if (!c.configured || c.installed)
+        return ESP_ERR_INVALID_STATE;
+    c.installed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+    auto& c = mock::rmt.channels[channel];
+    if (!c.installed)
+        return ESP_ERR_INVALID_STATE;
+    c = mock::RmtChannel();
+    return ESP_OK;
+}
+
+inline rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg) {
+    auto previous = mock::rmt.txEnd;
+    mock::rmt.txEnd = { function, arg };
+    return previous;
+}
+
+inline esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+    mock::rmt.channels[channel].translator = fn;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_translator_set_context(rmt_channel_t channel, void* context) {
+    mock::rmt.channels[channel].context = context;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_translator_get_context(const size_t*, void** context) {
+    if (mock::rmt.translating < 0)
+        return ESP_ERR_INVALID_STATE;
+    *context = mock::rmt.channels[mock::rmt.translating].context;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool) {
+    auto& c = mock::rmt.channels[channel];
+    if (!c.installed || !c.translator)
+        return ESP_ERR_INVALID_STATE;
+    if (c.busy)
+        return ESP_ERR_TIMEOUT;
+
+    c.wire.clear();
+    mock::rmt.translating = channel;
+    rmt_item32_t half[SOC_RMT_MEM_WORDS_PER_CHANNEL / 2];
+    size_t offset = 0;
+    while (offset < src_size) {
+        size_t consumed = 0, items = 0;
+        c.translator(src + offset, half, src_size - offset, SOC_RMT_MEM_WORDS_PER_CHANNEL / 2, &consumed, &items);
+        if (consumed == 0)
+            break;
+        offset += consumed;
+        for (size_t i = 0; i != items; i++)
+            c.wire.push_back(half[i].val);
+    }
+    mock::rmt.translating = -1;
+    mock::rmt.started(channel);
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* items, int count, bool) {
+    auto& c = mock::rmt.channels[channel];
+    if (!c.installed)
+        return ESP_ERR_INVALID_STATE;
+    if (c.busy)
+        return ESP_ERR_TIMEOUT;
+    c.wire.clear();
+    for (int i = 0; i != count; i++)
+        c.wire.push_back(items[i].val);
+    mock::rmt.started(channel);
+    return ESP_OK;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+// Simulated SPI master. Transactions complete immediately, everything sent is logged
+// in mock::spi, so tests can check the exact bit stream and transaction counts.
+
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2,
+    SPI_HOST_MAX,
+} spi_host_device_t;
+
+#define HSPI_HOST SPI2_HOST
+#define VSPI_HOST SPI3_HOST
+
+typedef enum {
+    SPI_DMA_DISABLED = 0,
+    SPI_DMA_CH1 = 1,
+    SPI_DMA_CH2 = 2,
+    SPI_DMA_CH_AUTO = 3,
+} spi_common_dma_t;
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+struct spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void* user;
+    union {
+        const void* tx_buffer;
+        uint8_t tx_data[4];
+    };
+    union {
+        void* rx_buffer;
+        uint8_t rx_data[4];
+    };
+};
+
+namespace mock {
+
+struct SpiDevice {
+    spi_host_device_t host;
+    spi_device_interface_config_t config;
+    std::deque<spi_transaction_t*> inFlight;
+};
+
+struct SpiState {
+    bool busInitialized[SPI_HOST_MAX] = {};
+    spi_bus_config_t bus[SPI_HOST_MAX] = {};
+    int devices[SPI_HOST_MAX] = {};
+
+    // Statistics of everything queued since the last reset()
+    size_t transactions = 0;
+    size_t bits = 0;
+    size_t rejected = 0;
+
+    // Copy of the sent data, only when enabled (benchmarks turn it off)
+    bool record = true;
+    std::vector<uint8_t> wire;
+
+    // While set, queued transactions never finish, i.e. the wire is still busy
+    bool stalled = false;
+
+    void reset() {
+        transactions = bits = rejected = 0;
+        stalled = false;
+        wire.clear();
+    }
+};
+
+inline SpiState spi;
+
+} // namespace mock
+
+typedef mock::SpiDevice* spi_device_handle_t;
+
+inline esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* config, int) {
+    if (host >= SPI_HOST_MAX || mock::spi.busInitialized[host])
+        return ESP_ERR_INVALID_STATE;
+    mock::spi.busInitialized[host] = true;
+    mock::spi.bus[host] = *config;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_free(spi_host_device_t host) {
+    if (!mock::spi.busInitialized[host] || mock::spi.devices[host] != 0)
+        return ESP_ERR_INVALID_STATE;
+    mock::spi.busInitialized[host] = false;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_add_device(
+    spi_host_device_t host, const spi_device_interface_config_t* config, spi_device_handle_t* handle) {
+    if (!mock::spi.busInitialized[host])
+        return ESP_ERR_INVALID_STATE;
+    *handle = new mock::SpiDevice { host, *config, {} };
+    mock::spi.devices[host]++;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    if (!handle->inFlight.empty())
+        return ESP_ERR_INVALID_STATE;
+    mock::spi.devices[handle->host]--;
+    delete handle;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, TickType_t) {
+    // A real queue would block until a slot frees up, nobody frees it here
+    if ((int)handle->inFlight.size() >= handle->config.queue_size) {
+        mock::spi.rejected++;
+        return ESP_ERR_TIMEOUT;
+    }
+    handle->inFlight.push_back(trans);
+    mock::spi.transactions++;
+    mock::spi.bits += trans->length;
+    if (mock::spi.record) {
+        // The log is byte granular, a partial last byte is stored whole
+        auto* data = static_cast<const uint8_t*>(trans->tx_buffer);
+        mock::spi.wire.insert(mock::spi.wire.end(), data, data + (trans->length + 7) / 8);
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans, TickType_t) {
+    if (handle->inFlight.empty() || mock::spi.stalled)
+        return ESP_ERR_TIMEOUT;
+    *trans = handle->inFlight.front();
+    handle->inFlight.pop_front();
+    return ESP_OK;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// Helpers shared by the tests of the SPI strips, not part of the IDF API
+
+#include "driver/spi_master.h"
+
+// Clears the log of the SPI mock. Benchmarks and long sweeps turn recording of the
+// bit stream off, counting bits and transactions is cheap.
+inline void resetSpi(bool record = true) {
+    mock::spi.reset();
+    mock::spi.record = record;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF header, so the sources can be unit tested on a PC
+#define IRAM_ATTR
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+namespace mock {
+// Number of heap_caps allocations, to check that buffers get reused
+inline size_t heapAllocations = 0;
+}
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    mock::heapAllocations++;
+    return malloc(size);
+}
+
+inline void* heap_caps_calloc(size_t n, size_t size, uint32_t) {
+    mock::heapAllocations++;
+    return calloc(n, size);
+}
+inline void heap_caps_free(void* ptr) { free(ptr); }
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "esp_system.h"
+#include <cstdint>
+
+typedef void (*esp_ipc_func_t)(void* arg);
+
+inline esp_err_t esp_ipc_call_blocking(uint32_t, esp_ipc_func_t func, void* arg) {
+    func(arg);
+    return ESP_OK;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Single threaded stand-in: nothing ever blocks, a "blocking" call which would wait
+// forever on a real device fails instead.
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY (TickType_t)0xffffffffUL
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#include "freertos/task.h"
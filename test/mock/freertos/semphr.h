@@ -0,0 +1,31 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+struct MockSemaphore {
+    UBaseType_t count;
+};
+
+typedef MockSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return new MockSemaphore { 0 }; }
+// Taking a held mutex would deadlock a single thread, so it fails like any other take
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new MockSemaphore { 1 }; }
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t) {
+    if (s->count == 0)
+        return pdFALSE;
+    s->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    if (s->count == 1)
+        return pdFALSE;
+    s->count = 1;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t*) { return xSemaphoreGive(s); }
+inline UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t s) { return s->count; }
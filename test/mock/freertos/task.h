@@ -0,0 +1,9 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+namespace mock {
+inline TickType_t tickCount = 0;
+}
+
+inline TickType_t xTaskGetTickCount() { return mock::tickCount; }
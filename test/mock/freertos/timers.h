@@ -0,0 +1,71 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <algorithm>
+#include <vector>
+
+// Timers don't run by themselves, a test fires them with mock::fire(), as if the timer
+// task ran the callback. Pended functions run immediately, as if the timer task picked
+// them up right away.
+
+typedef void (*PendedFunction_t)(void*, uint32_t);
+
+struct MockTimer;
+typedef MockTimer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+struct MockTimer {
+    TickType_t period;
+    bool autoReload;
+    bool active;
+    void* id;
+    TimerCallbackFunction_t callback;
+};
+
+namespace mock {
+
+// Timers which were created and not deleted yet, oldest first
+inline std::vector<TimerHandle_t> timers;
+
+// Runs the callback of an active timer, a one-shot timer stops
+inline bool fire(TimerHandle_t timer) {
+    if (!timer->active)
+        return false;
+    if (!timer->autoReload)
+        timer->active = false;
+    timer->callback(timer);
+    return true;
+}
+
+} // namespace mock
+
+inline TimerHandle_t xTimerCreate(
+    const char*, TickType_t period, UBaseType_t autoReload, void* id, TimerCallbackFunction_t callback) {
+    auto timer = new MockTimer { period, autoReload != pdFALSE, false, id, callback };
+    mock::timers.push_back(timer);
+    return timer;
+}
+
+inline BaseType_t xTimerStart(TimerHandle_t timer, TickType_t) {
+    timer->active = true;
+    return pdPASS;
+}
+
+inline BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t) {
+    timer->period = period;
+    timer->active = true;
+    return pdPASS;
+}
+
+inline BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t) {
+    mock::timers.erase(std::find(mock::timers.begin(), mock::timers.end(), timer));
+    delete timer;
+    return pdPASS;
+}
+
+inline BaseType_t xTimerPendFunctionCall(PendedFunction_t func, void* arg1, uint32_t arg2, TickType_t) {
+    func(arg1, arg2);
+    return pdPASS;
+}
+
+inline void* pvTimerGetTimerID(TimerHandle_t timer) { return timer->id; }
@@ -0,0 +1,175 @@
+#include <LedOutput.h>
+#include <Noise.h>
+#include <algorithm>
+#include <catch.hpp>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Straightforward float implementation of the reference improved noise, -1..1
+struct FloatPerlin {
+    int p[512];
+
+    FloatPerlin() {
+        // Recover the permutation from the integer noise would be circular, so it's repeated here
+        static const int perm[256] = { 151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36,
+            103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219,
+            203, 117, 35, 11, 32, 57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71,
+            134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46,
+            245, 40, 244, 102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
+            135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123, 5, 202, 38,
+            147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+            119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9, 129, 22, 39, 253, 19, 98, 108, 110,
+            79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179,
+            162, 241, 81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115,
+            121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215,
+            61, 156, 180 };
+        for (int i = 0; i != 512; i++)
+            p[i] = perm[i & 255];
+    }
+
+    static double fade(double t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+    static double lerp(double t, double a, double b) { return a + t * (b - a); }
+    static double grad(int hash, double x, double y, double z) {
+        int h = hash & 15;
+        double u = h < 8 ? x : y;
+        double v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+    }
+
+    double operator()(double x, double y, double z) const {
+        int X = int(std::floor(x)) & 255, Y = int(std::floor(y)) & 255, Z = int(std::floor(z)) & 255;
+        x -= std::floor(x);
+        y -= std::floor(y);
+        z -= std::floor(z);
+        double u = fade(x), v = fade(y), w = fade(z);
+        int A = p[X] + Y, AA = p[A] + Z, AB = p[A + 1] + Z, B = p[X + 1] + Y, BA = p[B] + Z, BB = p[B + 1] + Z;
+        return lerp(w,
+            lerp(v, lerp(u, grad(p[AA], x, y, z), grad(p[BA], x - 1, y, z)),
+                lerp(u, grad(p[AB], x, y - 1, z), grad(p[BB], x - 1, y - 1, z))),
+            lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1), grad(p[BA + 1], x - 1, y, z - 1)),
+                lerp(u, grad(p[AB + 1], x, y - 1, z - 1), grad(p[BB + 1], x - 1, y - 1, z - 1))));
+    }
+};
+
+double toUnit(uint32_t v) { return v / 65536.0; }
+
+// Hash of the row in "Rows match single samples", recorded from this implementation
+const uint32_t GOLDEN_HASH = 0x9cd573b2;
+
+} // namespace
+
+TEST_CASE("Integer noise follows the float reference", "[noise]") {
+    FloatPerlin reference;
+    double maxError = 0;
+    for (uint32_t x = 0; x < 8 * 65536; x += 7919)
+        for (uint32_t y = 0; y < 4 * 65536; y += 12347)
+            for (uint32_t z = 0; z < 2 * 65536; z += 17389) {
+                double expected = 32768 + reference(toUnit(x), toUnit(y), toUnit(z)) * 4096 * 9;
+                expected = std::min(65535.0, std::max(0.0, expected));
+                maxError = std::max(maxError, std::abs(noise16(x, y, z) - expected));
+            }
+    CAPTURE(maxError);
+    // A few LSB of the 12-bit cell fractions, scaled up by 9
+    REQUIRE(maxError < 100);
+}
+
+TEST_CASE("Noise is centered and uses the output range", "[noise]") {
+    uint16_t lo = 65535, hi = 0;
+    double sum = 0;
+    int count = 0;
+    for (uint32_t x = 0; x < 64 * 65536; x += 4099)
+        for (uint32_t y = 0; y < 16 * 65536; y += 65537 / 3) {
+            uint16_t v = noise16(x, y, x ^ y);
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+            sum += v;
+            count++;
+        }
+    CAPTURE(lo, hi, sum / count);
+    REQUIRE(lo < 8000);
+    REQUIRE(hi > 57000);
+    REQUIRE(std::abs(sum / count - 32768) < 2000);
+
+    // The lattice points are zero crossings
+    REQUIRE(noise16(5 << 16, 7 << 16, 3 << 16) == 32768);
+    REQUIRE(noise16(5 << 16, 7 << 16) == 32768);
+}
+
+TEST_CASE("Noise is smooth", "[noise]") {
+    const uint32_t step = 65536 / 64;
+    int maxJump = 0;
+    uint16_t prev = noise16(0, 12345, 777);
+    for (uint32_t x = step; x < 32 * 65536; x += step) {
+        uint16_t v = noise16(x, 12345, 777);
+        maxJump = std::max(maxJump, std::abs(int(v) - prev));
+        prev = v;
+    }
+    CAPTURE(maxJump);
+    REQUIRE(maxJump < 2500);
+}
+
+TEST_CASE("Rows match single samples and are deterministic", "[noise]") {
+    const int count = 300;
+    std::vector<uint16_t> row2(count), row3(count);
+    const uint32_t x = 123456, step = 3001, y = 98765, z = 4242;
+    noiseRow16(row2.data(), count, x, step, y);
+    noiseRow16(row3.data(), count, x, step, y, z);
+    uint32_t hash = 0;
+    for (int i = 0; i != count; i++) {
+        CAPTURE(i);
+        REQUIRE(row2[i] == noise16(x + i * step, y));
+        REQUIRE(row3[i] == noise16(x + i * step, y, z));
+        hash = hash * 31 + row3[i];
+    }
+
+    CAPTURE(hash);
+    // Integer only, must be the same on every platform
+    REQUIRE(hash == GOLDEN_HASH);
+
+    std::vector<uint16_t> again(count);
+    noiseRow16(again.data(), count, x, step, y, z);
+    REQUIRE(again == row3);
+    REQUIRE(noise8(x, y, z) == noise16(x, y, z) >> 8);
+}
+
+TEST_CASE("fillNoise picks palette colors", "[noise]") {
+    Palette palette;
+    for (int i = 0; i != Palette::SIZE; i++)
+        palette[i] = Rgb(i, 255 - i, 0);
+    std::vector<Rgb> pixels(100);
+    LedSpan<Rgb> strip(pixels.data(), pixels.size());
+    fillNoise(strip, palette, 1000, 5000, 2000, 3000);
+    for (int i = 0; i != 100; i++)
+        REQUIRE(pixels[i] == palette[noise16(1000 + i * 5000, 2000, 3000) >> 8]);
+}
+
+TEST_CASE("Noise throughput", "[!benchmark][noise]") {
+    const int count = 1000;
+    FloatPerlin reference;
+    std::vector<uint16_t> values(count);
+    std::vector<float> floats(count);
+    const uint32_t step = 65536 / 20;
+    uint32_t z = 0;
+
+    BENCHMARK("float Perlin 3D, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            floats[i] = reference(toUnit(i * step), 0.5, toUnit(z));
+        z += 1000;
+    }
+    BENCHMARK("noise16 3D per sample, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            values[i] = noise16(i * step, 32768, z);
+        z += 1000;
+    }
+    BENCHMARK("noiseRow16 3D, 1000 LEDs") {
+        noiseRow16(values.data(), count, 0, step, 32768, z);
+        z += 1000;
+    }
+    BENCHMARK("noiseRow16 2D, 1000 LEDs") {
+        noiseRow16(values.data(), count, z, step, 32768);
+        z += 1000;
+    }
+    REQUIRE(values[0] != 1);
+}
@@ -0,0 +1,82 @@
+#include <Palette.h>
+#include <catch.hpp>
+#include <cstdlib>
+#include <vector>
+
+#include <LedOutput.h>
+
+TEST_CASE("RGB palette interpolates between the stops", "[palette]") {
+    auto palette = Palette::rgb({ { 0, Rgb(0, 0, 0) }, { 100, Rgb(200, 100, 0) }, { 255, Rgb(200, 100, 255) } });
+    REQUIRE(palette[0] == Rgb(0, 0, 0));
+    REQUIRE(palette[50] == Rgb(100, 50, 0));
+    REQUIRE(palette[100] == Rgb(200, 100, 0));
+    REQUIRE(palette[255] == Rgb(200, 100, 255));
+
+    for (int i = 1; i != 100; i++) {
+        CAPTURE(i);
+        REQUIRE(palette[i].r >= palette[i - 1].r);
+        REQUIRE(std::abs(palette[i].r - 2 * i) <= 1);
+    }
+}
+
+TEST_CASE("Palette keeps the edge colors outside of the stops", "[palette]") {
+    auto palette = Palette::rgb({ { 64, Rgb(10, 20, 30) }, { 128, Rgb(50, 60, 70) } });
+    REQUIRE(palette[0] == Rgb(10, 20, 30));
+    REQUIRE(palette[64] == Rgb(10, 20, 30));
+    REQUIRE(palette[128] == Rgb(50, 60, 70));
+    REQUIRE(palette[255] == Rgb(50, 60, 70));
+}
+
+TEST_CASE("HSV palette matches the per-pixel HSV conversion", "[palette]") {
+    // Full rainbow, the middle stop keeps the hue going the same way as the index
+    auto palette
+        = Palette::hsv({ { 0, Hsv(0, 255, 255) }, { 128, Hsv(128, 255, 255) }, { 255, Hsv(255, 255, 255) } });
+    for (int i = 0; i != 256; i++) {
+        CAPTURE(i);
+        REQUIRE(palette[i] == Rgb(Hsv(i, 255, 255)));
+    }
+
+    // Red to blue is shorter over magenta
+    auto wrapped = Palette::hsv({ { 0, Hsv(0, 255, 255) }, { 255, Hsv(170, 255, 255) } });
+    REQUIRE(wrapped[128] == Rgb(Hsv(213, 255, 255)));
+}
+
+TEST_CASE("fillFromPalette walks the palette with the given step", "[palette]") {
+    Palette palette;
+    for (int i = 0; i != Palette::SIZE; i++)
+        palette[i] = Rgb(i, 0, 0);
+
+    std::vector<Rgb> pixels(100);
+    LedSpan<Rgb> strip(pixels.data(), pixels.size());
+    fillFromPalette(strip, palette, 250, 3);
+    REQUIRE(pixels[0].r == 250);
+    REQUIRE(pixels[1].r == 253);
+    REQUIRE(pixels[2].r == 0);
+
+    fillFromPaletteFine(strip, palette, 0, 128);
+    REQUIRE(pixels[0].r == 0);
+    REQUIRE(pixels[1].r == 0);
+    REQUIRE(pixels[2].r == 1);
+    REQUIRE(pixels[99].r == 49);
+}
+
+TEST_CASE("Palette lookup vs. HSV conversion", "[!benchmark][palette]") {
+    const int count = 1000;
+    std::vector<Rgb> pixels(count);
+    LedSpan<Rgb> strip(pixels.data(), pixels.size());
+    const PaletteStop<Hsv> stops[] = { { 0, Hsv(0, 255, 255) }, { 128, Hsv(128, 255, 255) }, { 255, Hsv(255, 255, 255) } };
+    auto rainbow = Palette::hsv(stops, 3);
+
+    uint8_t start = 0;
+    BENCHMARK("Hsv -> Rgb per pixel, 1000 LEDs") {
+        for (int i = 0; i != count; i++)
+            pixels[i] = Hsv(uint8_t(start + i), 255, 255);
+        start++;
+    }
+    BENCHMARK("fillFromPalette, 1000 LEDs") {
+        fillFromPalette(strip, rainbow, start);
+        start++;
+    }
+    BENCHMARK("building a HSV palette") { rainbow = Palette::hsv(stops, 3); }
+    REQUIRE(pixels[10] == rainbow[uint8_t(start - 1 + 10)]);
+}
@@ -0,0 +1,171 @@
+#include <Power.h>
+#include <RmtSymbols.h>
+#include <catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using smartleds::nscale8;
+
+namespace {
+
+std::vector<Rgb> randomFrame(int count, std::mt19937& gen, int max = 255) {
+    std::uniform_int_distribution<int> dist(0, max);
+    std::vector<Rgb> ret;
+    for (int i = 0; i != count; i++)
+        ret.emplace_back(dist(gen), dist(gen), dist(gen), dist(gen));
+    return ret;
+}
+
+// Plain floating point sum of the model
+double referenceMa(const PowerModel& model, const std::vector<Rgb>& frame) {
+    double ret = 0;
+    for (const auto& p : frame)
+        ret += (p.r * model.redMa + p.g * model.greenMa + p.b * model.blueMa) / 255.0 + model.idleUa / 1000.0;
+    return ret;
+}
+
+} // namespace
+
+TEST_CASE("Channel sums match plain sums", "[power]") {
+    std::mt19937 gen(7);
+    for (int count : { 0, 1, 255, 256, 257, 1000, 5000 }) {
+        auto frame = randomFrame(count, gen);
+        uint32_t r = 0, g = 0, b = 0;
+        for (const auto& p : frame) {
+            r += p.r;
+            g += p.g;
+            b += p.b;
+        }
+        auto sums = channelSums(frame.data(), count);
+        CAPTURE(count);
+        REQUIRE(sums.r == r);
+        REQUIRE(sums.g == g);
+        REQUIRE(sums.b == b);
+        REQUIRE(sums.count == count);
+    }
+
+    // All channels at full scale over many blocks
+    std::vector<Rgb> white(3000, Rgb(255, 255, 255));
+    auto sums = channelSums(white.data(), white.size());
+    REQUIRE(sums.r == 255 * 3000);
+    REQUIRE(sums.b == 255 * 3000);
+}
+
+TEST_CASE("Estimated current matches the reference sum", "[power]") {
+    std::mt19937 gen(11);
+    const PowerModel model = { 17, 12, 9, 700 };
+    for (int count : { 1, 60, 300, 2000 }) {
+        auto frame = randomFrame(count, gen);
+        const double ref = referenceMa(model, frame);
+        const uint32_t est = estimateCurrentMa(model, frame.data(), count);
+        CAPTURE(count, ref);
+        // Rounded up, never under the reference
+        REQUIRE(est >= ref);
+        REQUIRE(est < ref + 2);
+    }
+
+    std::vector<Rgb> white(100, Rgb(255, 255, 255));
+    REQUIRE(estimateCurrentMa(POWER_WS2812, white.data(), white.size()) == 100 * 61);
+    std::vector<Rgb> black(100, Rgb(0, 0, 0));
+    REQUIRE(estimateCurrentMa(POWER_WS2812, black.data(), black.size()) == 100);
+}
+
+TEST_CASE("Power scale keeps the frame under the budget", "[power]") {
+    std::mt19937 gen(3);
+    const auto& model = POWER_WS2812B;
+    for (int i = 0; i != 200; i++) {
+        auto frame = randomFrame(500, gen);
+        const uint32_t full = estimateCurrentMa(model, frame.data(), frame.size());
+        const uint32_t budget = std::uniform_int_distribution<uint32_t>(600, full + 100)(gen);
+        const auto sums = channelSums(frame.data(), frame.size());
+        const uint8_t scale = powerScale(model, sums, budget);
+        CAPTURE(full, budget, int(scale));
+
+        std::vector<Rgb> scaled(frame);
+        nscale8(scaled, scale);
+        REQUIRE(referenceMa(model, scaled) <= budget);
+        if (full <= budget) {
+            REQUIRE(scale == 255);
+        } else {
+            // Not dimmer than it needs to be
+            std::vector<Rgb> brighter(frame);
+            nscale8(brighter, std::min(scale + 2, 255));
+            REQUIRE(estimateCurrentMa(model, brighter.data(), brighter.size()) + 2 >= budget);
+        }
+    }
+
+    std::vector<Rgb> frame(100, Rgb(255, 255, 255));
+    auto sums = channelSums(frame.data(), frame.size());
+    REQUIRE(powerScale(model, sums, 50) == 0);
+    REQUIRE(powerScale(model, sums, 100000) == 255);
+}
+
+TEST_CASE("limitPower scales the strip in place", "[power]") {
+    std::mt19937 gen(5);
+    auto frame = randomFrame(300, gen);
+    const uint32_t full = estimateCurrentMa(POWER_SK6812, frame.data(), frame.size());
+    const uint8_t scale = limitPower(frame, POWER_SK6812, full / 2);
+    REQUIRE(scale < 130);
+    REQUIRE(estimateCurrentMa(POWER_SK6812, frame.data(), frame.size()) <= full / 2);
+    REQUIRE(limitPower(frame, POWER_SK6812, full) == 255);
+}
+
+TEST_CASE("The encoder's channel scaling is scale8", "[power]") {
+    for (int v = 0; v != 256; v++)
+        for (int s = 0; s != 256; s++)
+            REQUIRE(detail::scaleChannel(v, s) == smartleds::scale8(v, s));
+}
+
+TEST_CASE("Scaled encoding matches encoding of the scaled buffer", "[power]") {
+    const uint32_t BIT0 = 0x00010002, BIT1 = 0x00030004;
+    std::mt19937 gen(9);
+    const int count = 100;
+    auto frame = randomFrame(count, gen);
+    std::vector<uint16_t> order(count);
+    for (int i = 0; i != count; i++)
+        order[i] = (i * 37) % count;
+
+    for (int scale : { 0, 1, 100, 254, 255 }) {
+        std::vector<Rgb> scaled(frame);
+        nscale8(scaled, scale);
+        std::vector<uint32_t> direct(count * detail::SYMBOLS_PER_PIXEL), fused(direct.size());
+        for (const uint16_t* o : { (const uint16_t*)nullptr, (const uint16_t*)order.data() }) {
+            detail::encodeSymbols(scaled.data(), o, count, BIT0, BIT1, direct.data());
+            auto* end = detail::encodeSymbols(frame.data(), o, count, scale, BIT0, BIT1, fused.data());
+            CAPTURE(scale);
+            REQUIRE(end == fused.data() + fused.size());
+            REQUIRE(direct == fused);
+        }
+    }
+}
+
+TEST_CASE("Current estimation", "[!benchmark][power]") {
+    std::mt19937 gen(1);
+    auto frame = randomFrame(1000, gen);
+    std::vector<uint32_t> symbols(frame.size() * detail::SYMBOLS_PER_PIXEL);
+    uint32_t total = 0;
+
+    BENCHMARK("per-channel sum, 1000 LEDs") {
+        uint32_t r = 0, g = 0, b = 0;
+        for (const auto& p : frame) {
+            r += p.r;
+            g += p.g;
+            b += p.b;
+        }
+        total += r + g + b;
+    }
+    BENCHMARK("channelSums, 1000 LEDs") {
+        auto sums = channelSums(frame.data(), frame.size());
+        total += sums.r + sums.g + sums.b;
+    }
+    BENCHMARK("nscale8 + encode, 1000 LEDs") {
+        nscale8(frame, 200);
+        detail::encodeSymbols(frame.data(), nullptr, frame.size(), 0, 1, symbols.data());
+    }
+    BENCHMARK("scaled encode, 1000 LEDs") {
+        detail::encodeSymbols(frame.data(), nullptr, frame.size(), 200, 0, 1, symbols.data());
+    }
+    REQUIRE(total != 1);
+}
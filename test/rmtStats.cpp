@@ -0,0 +1,84 @@
+#include <RmtDriver.h>
+#include <catch.hpp>
+#include <type_traits>
+
+using detail::RmtProbe;
+
+static_assert(std::is_empty<RmtProbe<false>>::value, "disabled probe has no state");
+
+// The drivers derive from the probe, so the disabled one takes no space in them
+struct WithDisabledProbe : private RmtProbe<false> {
+    uint32_t state;
+};
+static_assert(sizeof(WithDisabledProbe) == sizeof(uint32_t), "disabled probe is an empty base");
+static_assert(std::is_base_of<detail::RmtDriverProbe, detail::RmtDriver>::value, "the driver derives from the probe");
+
+TEST_CASE("Disabled probe reports nothing", "[rmtstats]") {
+    RmtProbe<false> probe;
+    probe.frameStart();
+    probe.refillEnd(probe.refillStart());
+    probe.frameEnd();
+    auto stats = probe.stats();
+    REQUIRE(stats.frames == 0);
+    REQUIRE(stats.refills == 0);
+    REQUIRE(stats.refillCyclesAverage() == 0);
+}
+
+TEST_CASE("Refill cycles and frame times", "[rmtstats]") {
+    RmtProbe<true> probe;
+    REQUIRE(probe.stats().refillCyclesMin == 0);
+
+    probe.recordRefill(300, 1000);
+    probe.recordRefill(100, 1030);
+    probe.recordRefill(200, 1060);
+    probe.recordFrame(1500);
+    probe.recordFrame(1200);
+
+    auto stats = probe.stats();
+    REQUIRE(stats.refills == 3);
+    REQUIRE(stats.refillCyclesMin == 100);
+    REQUIRE(stats.refillCyclesMax == 300);
+    REQUIRE(stats.refillCyclesAverage() == 200);
+    REQUIRE(stats.frames == 2);
+    REQUIRE(stats.lastFrameUs == 1200);
+    REQUIRE(stats.maxFrameUs == 1500);
+    REQUIRE(stats.underruns == 0);
+
+    probe.reset();
+    REQUIRE(probe.stats().refills == 0);
+    REQUIRE(probe.stats().maxFrameUs == 0);
+}
+
+TEST_CASE("Late refills are underruns", "[rmtstats]") {
+    // 64 symbols of the slower WS2812 bit take 64 * 1.3 us
+    const uint32_t drain = detail::drainTimeUs({ 350, 700, 800, 600, 50000 }, 64);
+    REQUIRE(drain == 83);
+
+    RmtProbe<true> probe;
+    probe.setDrainTime(drain);
+    probe.frameStart();
+    probe.recordRefill(100, 1000);
+    probe.recordRefill(100, 1040);
+    probe.recordRefill(100, 1123);
+    REQUIRE(probe.stats().underruns == 0);
+    probe.recordRefill(100, 1207);
+    REQUIRE(probe.stats().underruns == 1);
+
+    // The first refill of a frame has nothing to be late after
+    probe.frameStart();
+    probe.recordRefill(100, 5000);
+    REQUIRE(probe.stats().underruns == 1);
+}
+
+TEST_CASE("Probe with the real clocks", "[rmtstats]") {
+    RmtProbe<true> probe;
+    probe.frameStart();
+    for (int i = 0; i != 10; i++)
+        probe.refillEnd(probe.refillStart());
+    probe.frameEnd();
+    auto stats = probe.stats();
+    REQUIRE(stats.refills == 10);
+    REQUIRE(stats.frames == 1);
+    REQUIRE(stats.refillCyclesMin <= stats.refillCyclesAverage());
+    REQUIRE(stats.refillCyclesAverage() <= stats.refillCyclesMax);
+}
@@ -0,0 +1,94 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <vector>
+
+namespace {
+
+// Zone pattern used by the tests, color depends only on the zone and local index
+Rgb zoneColor(int segment, int idx) { return Rgb(segment + 1, idx, 255 - idx); }
+
+} // namespace
+
+TEST_CASE("Segment maps logical to physical pixels", "[segments]") {
+    std::vector<Rgb> strip(20);
+    LedSpan<Rgb> leds(strip.data(), strip.size());
+
+    auto forward = segment(leds, { 2, 4 });
+    auto backward = segment(leds, { 10, 4, 1, true });
+    auto every2nd = segment(leds, { 14, 3, 2 });
+    REQUIRE(forward.size() == 4);
+
+    for (int i = 0; i != 4; i++) {
+        forward[i] = Rgb(1, i, 0);
+        backward[i] = Rgb(2, i, 0);
+    }
+    for (int i = 0; i != 3; i++)
+        every2nd[i] = Rgb(3, i, 0);
+
+    REQUIRE(strip[2] == Rgb(1, 0, 0));
+    REQUIRE(strip[5] == Rgb(1, 3, 0));
+    REQUIRE(strip[10] == Rgb(2, 3, 0));
+    REQUIRE(strip[13] == Rgb(2, 0, 0));
+    REQUIRE(strip[14] == Rgb(3, 0, 0));
+    REQUIRE(strip[15] == Rgb());
+    REQUIRE(strip[18] == Rgb(3, 2, 0));
+    REQUIRE(strip[1] == Rgb());
+    REQUIRE(strip[6] == Rgb());
+}
+
+TEST_CASE("SegmentMap renders the same as drawing each segment", "[segments]") {
+    const int count = 64;
+    SegmentMap map(count, { { 0, 10 }, { 10, 10, 1, true }, { 21, 8, 2 }, { 40, 20, 1, true }, { 100, 5 } });
+    REQUIRE(map.segmentCount() == 5);
+    REQUIRE(map.owner(20) == SegmentMap::NONE);
+    REQUIRE(map.owner(19) == 1);
+    REQUIRE(map.localIndex(19) == 0);
+    REQUIRE(map.localIndex(10) == 9);
+
+    std::vector<Rgb> perSegment(count, Rgb(7, 7, 7)), oneSweep(count, Rgb(7, 7, 7));
+    LedSpan<Rgb> a(perSegment.data(), count), b(oneSweep.data(), count);
+
+    for (int s = 0; s != map.segmentCount(); s++) {
+        auto seg = map.segment(a, s);
+        for (int i = 0; i != seg.size(); i++) {
+            if (map.range(s).physical(i) < count)
+                seg[i] = zoneColor(s, i);
+        }
+    }
+    map.render(b, zoneColor);
+    REQUIRE(perSegment == oneSweep);
+}
+
+TEST_CASE("Later segments win where they overlap", "[segments]") {
+    SegmentMap map(10, { { 0, 10 }, { 4, 2 } });
+    std::vector<Rgb> strip(10);
+    LedSpan<Rgb> leds(strip.data(), strip.size());
+    map.render(leds, zoneColor);
+    REQUIRE(strip[3] == zoneColor(0, 3));
+    REQUIRE(strip[4] == zoneColor(1, 0));
+    REQUIRE(strip[5] == zoneColor(1, 1));
+    REQUIRE(strip[6] == zoneColor(0, 6));
+}
+
+TEST_CASE("Many small segments: per-segment passes vs. one sweep", "[!benchmark][segments]") {
+    const int count = 1200;
+    const int zones = 100;
+    std::vector<SegmentRange> ranges;
+    for (int z = 0; z != zones; z++) {
+        // Interleaved zones, e.g. every shelf is split into two windows
+        ranges.push_back({ (z / 2) * 24 + (z % 2), 12, 2, z % 4 == 1 });
+    }
+    SegmentMap map(count, ranges.data(), ranges.size());
+    std::vector<Rgb> strip(count);
+    LedSpan<Rgb> leds(strip.data(), count);
+
+    BENCHMARK("100 zones, per-segment passes") {
+        for (int s = 0; s != map.segmentCount(); s++) {
+            auto seg = map.segment(leds, s);
+            for (int i = 0; i != seg.size(); i++)
+                seg[i] = zoneColor(s, i);
+        }
+    }
+    BENCHMARK("100 zones, one sweep") { map.render(leds, zoneColor); }
+    REQUIRE(strip[0] == zoneColor(0, 0));
+}
@@ -0,0 +1,351 @@
+#include <RmtSymbols.h>
+#include <SmartLeds.h>
+#include <catch.hpp>
+#include <vector>
+
+namespace {
+
+// Decodes the symbols of the last frame on the channel back into pixels. The WS2812
+// one has a high time of 14 RMT ticks, zero 7.
+std::vector<Rgb> wire(int channel) {
+    const auto& symbols = mock::rmt.channels[channel].wire;
+    std::vector<Rgb> ret;
+    for (size_t i = 0; i + detail::SYMBOLS_PER_PIXEL <= symbols.size(); i += detail::SYMBOLS_PER_PIXEL) {
+        uint8_t grb[3] = {};
+        for (int bit = 0; bit != detail::SYMBOLS_PER_PIXEL; bit++)
+            grb[bit / 8] = (grb[bit / 8] << 1) | ((symbols[i + bit] & 0x7FFF) > 10);
+        ret.emplace_back(grb[1], grb[0], grb[2]);
+    }
+    return ret;
+}
+
+void fill(SmartLed& leds, Rgb color) {
+    for (auto& p : leds)
+        p = color;
+}
+
+} // namespace
+
+TEST_CASE("SmartLed sends its buffer through the translator", "[smartled]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 20, 5, 0, SingleBuffer);
+    for (int i = 0; i != leds.size(); i++)
+        leds[i] = Rgb(i, 255 - i, 3 * i);
+    REQUIRE(leds.show() == ESP_OK);
+    REQUIRE(leds.wait(0));
+    REQUIRE(mock::rmt.frames == 1);
+
+    auto sent = wire(0);
+    REQUIRE(sent.size() == 20);
+    for (int i = 0; i != leds.size(); i++)
+        REQUIRE(sent[i] == leds[i]);
+}
+
+TEST_CASE("Unchanged frames are skipped", "[smartled]") {
+    mock::rmt.reset();
+    for (auto buffer : { SingleBuffer, DoubleBuffer }) {
+        SmartLed leds(LED_WS2812, 10, 5, 0, buffer);
+        leds.setSkipUnchanged(true);
+        fill(leds, Rgb(10, 20, 30));
+        leds.show();
+        fill(leds, Rgb(10, 20, 30));
+        leds.show();
+        REQUIRE(leds.sentFrames() == 1);
+        REQUIRE(leds.skippedFrames() == 1);
+
+        fill(leds, Rgb(10, 20, 30));
+        leds[9] = Rgb(10, 20, 31);
+        leds.show();
+        REQUIRE(leds.sentFrames() == 2);
+        REQUIRE(wire(0)[9] == Rgb(10, 20, 31));
+        mock::rmt.reset();
+    }
+}
+
+TEST_CASE("A baked frame is not mistaken for the last shown one", "[smartled]") {
+    mock::rmt.reset();
+    for (auto buffer : { SingleBuffer, DoubleBuffer }) {
+        const Rgb a(100, 0, 0), b(0, 0, 100);
+        SmartLed leds(LED_WS2812, 10, 5, 0, buffer);
+        leds.setSkipUnchanged(true);
+
+        fill(leds, a);
+        leds.show();
+        fill(leds, b);
+        REQUIRE(leds.bake() == ESP_OK);
+        REQUIRE(leds.showBaked() == ESP_OK);
+        REQUIRE(wire(0)[0] == b);
+
+        // The strip shows B, so showing A again must go out
+        fill(leds, a);
+        leds.show();
+        REQUIRE(leds.skippedFrames() == 0);
+        REQUIRE(wire(0)[0] == a);
+        mock::rmt.reset();
+    }
+}
+
+TEST_CASE("Unchanged frames are resent after the keep-alive period", "[smartled]") {
+    mock::rmt.reset();
+    mock::tickCount = 1000;
+    SmartLed leds(LED_WS2812, 10, 5, 0, SingleBuffer);
+    leds.setSkipUnchanged(true, 100);
+    fill(leds, Rgb(1, 2, 3));
+    leds.show();
+    mock::tickCount += 99;
+    leds.show();
+    REQUIRE(leds.skippedFrames() == 1);
+    mock::tickCount += 1;
+    leds.show();
+    REQUIRE(leds.sentFrames() == 2);
+
+    // Turning the skipping off sends everything
+    leds.setSkipUnchanged(false);
+    leds.show();
+    REQUIRE(leds.sentFrames() == 3);
+    mock::tickCount = 0;
+}
+
+TEST_CASE("Refresh resends the last shown frame on every tick", "[smartled]") {
+    mock::rmt.reset();
+    for (auto buffer : { SingleBuffer, DoubleBuffer }) {
+        const Rgb a(100, 0, 0), b(0, 0, 100);
+        SmartLed leds(LED_WS2812, 10, 5, 0, buffer);
+        fill(leds, a);
+        leds.show();
+        REQUIRE(leds.startRefresh(10) == ESP_OK);
+        REQUIRE(leds.refreshing());
+        REQUIRE(mock::timers.size() == 1);
+        auto* timer = mock::timers.back();
+        REQUIRE(timer->period == 10);
+
+        // The refresh sends the baked symbols, not the buffer
+        fill(leds, b);
+        mock::rmt.reset();
+        REQUIRE(mock::fire(timer));
+        REQUIRE(mock::fire(timer));
+        REQUIRE(mock::rmt.frames == 2);
+        REQUIRE(wire(0) == std::vector<Rgb>(10, a));
+
+        // A tick while a frame is in flight is skipped
+        mock::rmt.stalled = true;
+        mock::fire(timer);
+        mock::fire(timer);
+        REQUIRE(mock::rmt.frames == 3);
+        mock::rmt.finish(0);
+        mock::rmt.stalled = false;
+
+        leds.stopRefresh();
+        mock::rmt.reset();
+    }
+}
+
+TEST_CASE("show() replaces the refreshed frame", "[smartled]") {
+    mock::rmt.reset();
+    for (auto buffer : { SingleBuffer, DoubleBuffer }) {
+        const Rgb a(100, 0, 0), b(0, 0, 100);
+        SmartLed leds(LED_WS2812, 10, 5, 0, buffer);
+        fill(leds, a);
+        leds.show();
+        REQUIRE(leds.startRefresh(10) == ESP_OK);
+        auto* timer = mock::timers.back();
+
+        fill(leds, b);
+        REQUIRE(leds.show() == ESP_OK);
+        REQUIRE(wire(0) == std::vector<Rgb>(10, b));
+
+        mock::rmt.reset();
+        mock::fire(timer);
+        REQUIRE(mock::rmt.frames == 1);
+        REQUIRE(wire(0) == std::vector<Rgb>(10, b));
+
+        leds.stopRefresh();
+        mock::rmt.reset();
+    }
+}
+
+TEST_CASE("Nothing is sent after stopRefresh()", "[smartled]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0);
+    fill(leds, Rgb(1, 2, 3));
+    leds.show();
+    REQUIRE(leds.startRefresh(10) == ESP_OK);
+    // Calling it again only changes the period
+    REQUIRE(leds.startRefresh(20) == ESP_OK);
+    REQUIRE(mock::timers.size() == 1);
+    REQUIRE(mock::timers.back()->period == 20);
+
+    mock::rmt.reset();
+    leds.stopRefresh();
+    REQUIRE_FALSE(leds.refreshing());
+    REQUIRE(mock::timers.empty());
+    REQUIRE(mock::rmt.frames == 0);
+
+    // show() is back to running the encoder
+    fill(leds, Rgb(4, 5, 6));
+    REQUIRE(leds.show() == ESP_OK);
+    REQUIRE(mock::rmt.frames == 1);
+    REQUIRE(wire(0)[0] == Rgb(4, 5, 6));
+}
+
+TEST_CASE("showBaked() works while refreshing", "[smartled]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0);
+    fill(leds, Rgb(1, 2, 3));
+    leds.show();
+    REQUIRE(leds.startRefresh(10) == ESP_OK);
+    auto* timer = mock::timers.back();
+
+    fill(leds, Rgb(4, 5, 6));
+    REQUIRE(leds.bake() == ESP_OK);
+    mock::fire(timer);
+    REQUIRE(leds.showBaked() == ESP_OK);
+    REQUIRE(wire(0)[0] == Rgb(4, 5, 6));
+
+    // The refresh repeats the baked frame
+    mock::rmt.reset();
+    mock::fire(timer);
+    REQUIRE(wire(0)[0] == Rgb(4, 5, 6));
+    leds.stopRefresh();
+}
+
+TEST_CASE("showAsync() token is pending until the frame is sent", "[smartled]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0);
+    fill(leds, Rgb(1, 2, 3));
+
+    mock::rmt.stalled = true;
+    auto token = leds.showAsync();
+    REQUIRE(token.error() == ESP_OK);
+    REQUIRE_FALSE(token.ready());
+    REQUIRE_FALSE(token.wait(0));
+    REQUIRE_FALSE(ShowToken::allReady({ token }));
+
+    mock::rmt.finish(0);
+    REQUIRE(token.ready());
+    REQUIRE(token.wait(0));
+    REQUIRE(ShowToken::waitAll({ token }, 0));
+    // Waiting doesn't consume the completion
+    REQUIRE(token.wait(0));
+    REQUIRE(leds.ready());
+    mock::rmt.stalled = false;
+}
+
+TEST_CASE("Failed showAsync() token is ready with the error", "[smartled]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0);
+    // Busy channel, e.g. another driver is sending on it
+    mock::rmt.channels[0].busy = true;
+    auto token = leds.showAsync();
+    REQUIRE(token.error() == ESP_ERR_TIMEOUT);
+    REQUIRE(token.ready());
+    REQUIRE(token.wait(0));
+    // The failed frame doesn't block the next one
+    mock::rmt.channels[0].busy = false;
+    REQUIRE(leds.show() == ESP_OK);
+}
+
+TEST_CASE("setOrder() sends the pixels in the table order", "[smartled]") {
+    mock::rmt.reset();
+    for (auto buffer : { SingleBuffer, DoubleBuffer }) {
+        SmartLed leds(LED_WS2812, 20, 5, 0, buffer);
+        uint16_t order[20];
+        for (int i = 0; i != 20; i++)
+            order[i] = (7 * i + 3) % 20;
+        leds.setOrder(order);
+
+        // The translator runs 32 symbols at a time, so pixels are split between refills
+        for (int i = 0; i != leds.size(); i++)
+            leds[i] = Rgb(i, 255 - i, 3 * i);
+        std::vector<Rgb> expected;
+        for (int i = 0; i != leds.size(); i++)
+            expected.push_back(leds[order[i]]);
+
+        REQUIRE(leds.show() == ESP_OK);
+        REQUIRE(wire(0) == expected);
+
+        // Baked frames use the order as well
+        for (int i = 0; i != leds.size(); i++)
+            leds[i] = Rgb(i, 255 - i, 3 * i);
+        REQUIRE(leds.bake() == ESP_OK);
+        REQUIRE(leds.showBaked() == ESP_OK);
+        REQUIRE(wire(0) == expected);
+
+        leds.setOrder(nullptr);
+        REQUIRE(leds.show() == ESP_OK);
+        REQUIRE(wire(0)[1] == Rgb(1, 254, 3));
+        mock::rmt.reset();
+    }
+}
+
+TEST_CASE("Power limit dims the sent frame only when over budget", "[smartled][power]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0, SingleBuffer);
+    const Rgb color(255, 128, 64);
+
+    // 10 LEDs of (255 + 128 + 64) / 255 * 13 mA, plus 1 mA idle each
+    leds.setPowerLimit(POWER_WS2812B, 1000);
+    fill(leds, color);
+    REQUIRE(leds.show() == ESP_OK);
+    REQUIRE(leds.powerScale() == 255);
+    REQUIRE(wire(0) == std::vector<Rgb>(10, color));
+
+    leds.setPowerLimit(POWER_WS2812B, 150);
+    fill(leds, color);
+    REQUIRE(leds.show() == ESP_OK);
+    const uint8_t scale = leds.powerScale();
+    REQUIRE(scale < 255);
+    REQUIRE(leds.estimatedCurrentMa() <= 150);
+    const Rgb dimmed(smartleds::scale8(color.r, scale), smartleds::scale8(color.g, scale),
+        smartleds::scale8(color.b, scale));
+    REQUIRE(wire(0) == std::vector<Rgb>(10, dimmed));
+    REQUIRE(estimateCurrentMa(POWER_WS2812B, wire(0).data(), 10) <= 150);
+    // The sent buffer is left alone
+    REQUIRE(leds[0] == color);
+
+    leds.setPowerLimit(POWER_WS2812B, 0);
+    fill(leds, color);
+    REQUIRE(leds.show() == ESP_OK);
+    REQUIRE(wire(0) == std::vector<Rgb>(10, color));
+}
+
+TEST_CASE("Tracked SmartLed writes keep the frame stats", "[smartled][framestats]") {
+    mock::rmt.reset();
+    SmartLed leds(LED_WS2812, 10, 5, 0, DoubleBuffer);
+    REQUIRE_FALSE(leds.trackingStats());
+    fill(leds, Rgb(10, 0, 0));
+    leds.trackStats();
+    REQUIRE(leds.trackingStats());
+    REQUIRE(leds.frameStats().sums().r == 100);
+    REQUIRE(leds.frameStats().lit() == 10);
+
+    leds.tracked(0) = Rgb(0, 0, 0);
+    leds.tracked(1) = Rgb(10, 200, 0);
+    leds.tracked(2) += Rgb(0, 0, 5);
+    auto sums = leds.frameStats().sums();
+    REQUIRE(sums.r == 90);
+    REQUIRE(sums.g == 200);
+    REQUIRE(sums.b == 5);
+    REQUIRE(leds.frameStats().lit() == 9);
+    REQUIRE(leds.frameStats().maxLevel() == 207);
+
+    FrameStats scanned;
+    scanned.scan(leds.begin(), leds.size());
+    REQUIRE(scanned.sums().r == sums.r);
+    REQUIRE(scanned.sums().g == sums.g);
+    REQUIRE(scanned.lit() == leds.frameStats().lit());
+
+    // The stats follow the buffers as they swap, the back buffer was never written
+    leds.show();
+    REQUIRE(leds.frameStats().black());
+    for (int i = 0; i != leds.size(); i++)
+        leds.tracked(i) = Rgb(0, 0, 7);
+    REQUIRE(leds.frameStats().sums().b == 70);
+    leds.show();
+    REQUIRE(leds.frameStats().sums().g == 200);
+
+    // A plain write needs a rescan
+    fill(leds, Rgb(1, 1, 1));
+    leds.trackStats();
+    REQUIRE(leds.frameStats().sums().b == 10);
+}
@@ -0,0 +1,121 @@
+#include <SmartLeds.h>
+#include <catch.hpp>
+
+TEST_CASE("Strips on different hosts get their own bus", "[spibus]") {
+    mock::spi.reset();
+    {
+        Apa102 first(10, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST);
+        LDP8806 second(10, 3, 4, SingleBuffer, 2000000, SPI3_HOST);
+        REQUIRE(mock::spi.busInitialized[SPI2_HOST]);
+        REQUIRE(mock::spi.busInitialized[SPI3_HOST]);
+
+        // Both frames are in flight at the same time
+        first.show();
+        second.show();
+        REQUIRE(mock::spi.rejected == 0);
+        first.wait();
+        second.wait();
+    }
+    REQUIRE_FALSE(mock::spi.busInitialized[SPI2_HOST]);
+    REQUIRE_FALSE(mock::spi.busInitialized[SPI3_HOST]);
+}
+
+TEST_CASE("Strips can share a host with separate CS pins", "[spibus]") {
+    mock::spi.reset();
+    {
+        Apa102 first(10, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST, 5);
+        {
+            Apa102 second(20, 1, 2, SingleBuffer, 1000000, ContiguousFrame, SPI2_HOST, 6);
+            REQUIRE(SpiBus::users(SPI2_HOST) == 2);
+            REQUIRE(mock::spi.devices[SPI2_HOST] == 2);
+
+            first.show();
+            second.show();
+            first.wait();
+            second.wait();
+            REQUIRE(mock::spi.transactions == 2);
+            REQUIRE(mock::spi.bits == size_t(Apa102::frameBits(10) + Apa102::frameBits(20)));
+        }
+        REQUIRE(SpiBus::users(SPI2_HOST) == 1);
+        REQUIRE(mock::spi.busInitialized[SPI2_HOST]);
+    }
+    REQUIRE(SpiBus::users(SPI2_HOST) == 0);
+    REQUIRE_FALSE(mock::spi.busInitialized[SPI2_HOST]);
+}
+
+TEST_CASE("Shared bus must keep its configuration", "[spibus]") {
+    mock::spi.reset();
+    REQUIRE(SpiBus::acquire(SPI2_HOST, 1, 2, 4096) == ESP_OK);
+    REQUIRE(SpiBus::acquire(SPI2_HOST, 1, 3, 4096) == ESP_ERR_INVALID_ARG);
+    REQUIRE(SpiBus::acquire(SPI2_HOST, 1, 2, 8192) == ESP_ERR_INVALID_SIZE);
+    REQUIRE(SpiBus::acquire(SPI2_HOST, 1, 2, 1024) == ESP_OK);
+    REQUIRE(SpiBus::users(SPI2_HOST) == 2);
+
+    REQUIRE(SpiBus::release(SPI2_HOST) == ESP_OK);
+    REQUIRE(mock::spi.busInitialized[SPI2_HOST]);
+    REQUIRE(SpiBus::release(SPI2_HOST) == ESP_OK);
+    REQUIRE_FALSE(mock::spi.busInitialized[SPI2_HOST]);
+    REQUIRE(SpiBus::release(SPI2_HOST) == ESP_ERR_INVALID_STATE);
+}
+
+TEST_CASE("Apa102 reconfigure reuses its buffers", "[spibus][reconfigure]") {
+    for (auto layout : { SeparateFrames, ContiguousFrame }) {
+        mock::spi.reset();
+        Apa102 leds(100, 1, 2, DoubleBuffer, 1000000, layout);
+        for (int i = 0; i != 100; i++)
+            leds[i] = Rgb(i, 0, 0);
+
+        const auto allocations = mock::heapAllocations;
+        REQUIRE(leds.reconfigure(50, 1000000) == ESP_OK);
+        REQUIRE(leds.size() == 50);
+        REQUIRE(leds.reconfigure(100, 4000000) == ESP_OK);
+        REQUIRE(mock::heapAllocations == allocations);
+
+        // Pixels which were cut off are not resurrected
+        REQUIRE(leds[49].r == 49);
+        REQUIRE(leds[50].r == 0);
+
+        REQUIRE(leds.reconfigure(300, 4000000) == ESP_OK);
+        REQUIRE(mock::heapAllocations > allocations);
+        REQUIRE(leds[49].r == 49);
+
+        mock::spi.reset();
+        leds.show();
+        leds.wait();
+        REQUIRE(mock::spi.bits == size_t(Apa102::frameBits(300)));
+        REQUIRE(mock::spi.devices[_SMARTLEDS_SPI_HOST] == 1);
+    }
+    REQUIRE(SpiBus::users(_SMARTLEDS_SPI_HOST) == 0);
+}
+
+TEST_CASE("Apa102 contiguous frame can grow over the bus transfer size", "[spibus][reconfigure]") {
+    mock::spi.reset();
+    {
+        Apa102 leds(10, 1, 2, SingleBuffer, 1000000, ContiguousFrame);
+        REQUIRE(leds.reconfigure(20000, 1000000) == ESP_OK);
+        REQUIRE(mock::spi.bus[_SMARTLEDS_SPI_HOST].max_transfer_sz >= (Apa102::frameBits(20000) + 7) / 8);
+
+        leds.show();
+        leds.wait();
+        REQUIRE(mock::spi.bits == size_t(Apa102::frameBits(20000)));
+
+        // A shared bus can't be re-initialized
+        Apa102 other(10, 1, 2, SingleBuffer, 1000000, ContiguousFrame, _SMARTLEDS_SPI_HOST, 5);
+        REQUIRE(other.reconfigure(40000, 1000000) == ESP_ERR_INVALID_SIZE);
+        REQUIRE(other.size() == 10);
+    }
+    REQUIRE_FALSE(mock::spi.busInitialized[_SMARTLEDS_SPI_HOST]);
+}
+
+TEST_CASE("LDP8806 reconfigure", "[spibus][reconfigure]") {
+    mock::spi.reset();
+    {
+        LDP8806 leds(64, 1, 2);
+        REQUIRE(leds.reconfigure(20, 1000000) == ESP_OK);
+        leds.show();
+        leds.wait();
+        REQUIRE(mock::spi.bits == 20 * 24 + 24);
+        REQUIRE(mock::spi.devices[_SMARTLEDS_SPI_HOST] == 1);
+    }
+    REQUIRE_FALSE(mock::spi.busInitialized[_SMARTLEDS_SPI_HOST]);
+}
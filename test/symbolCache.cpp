@@ -0,0 +1,119 @@
+#include <RmtSymbols.h>
+#include <algorithm>
+#include <catch.hpp>
+#include <vector>
+
+using detail::encodeSymbols;
+using detail::SYMBOLS_PER_PIXEL;
+
+static const uint32_t BIT0 = 0x00100008;
+static const uint32_t BIT1 = 0x00080010;
+
+// Stand-in for the RMT channel memory the symbols get copied into
+static const int RMT_MEM_WORDS = 64;
+
+static std::vector<Rgb> testFrame(int count) {
+    std::vector<Rgb> frame;
+    for (int i = 0; i != count; i++)
+        frame.emplace_back(i * 3, i * 5, i * 7);
+    return frame;
+}
+
+TEST_CASE("Pixels are encoded to GRB symbols MSB first", "[symbols]") {
+    Rgb pixel { 0x01, 0x80, 0xA5 };
+    std::vector<uint32_t> symbols(SYMBOLS_PER_PIXEL);
+    auto* end = encodeSymbols(&pixel, 1, BIT0, BIT1, symbols.data());
+    REQUIRE(end == symbols.data() + SYMBOLS_PER_PIXEL);
+
+    const uint32_t grb = (0x80 << 16) | (0x01 << 8) | 0xA5;
+    for (int i = 0; i != SYMBOLS_PER_PIXEL; i++) {
+        CAPTURE(i);
+        bool bit = (grb >> (SYMBOLS_PER_PIXEL - 1 - i)) & 1;
+        REQUIRE(symbols[i] == (bit ? BIT1 : BIT0));
+    }
+}
+
+TEST_CASE("Encoding a frame writes exactly 24 symbols per pixel", "[symbols]") {
+    const int count = 37;
+    auto frame = testFrame(count);
+    std::vector<uint32_t> symbols(count * SYMBOLS_PER_PIXEL + 1, 0xDEADBEEF);
+    auto* end = encodeSymbols(frame.data(), count, BIT0, BIT1, symbols.data());
+    REQUIRE(end - symbols.data() == count * SYMBOLS_PER_PIXEL);
+    REQUIRE(symbols.back() == 0xDEADBEEF);
+}
+
+TEST_CASE("Baked symbols vs. encoding every frame", "[!benchmark][symbols]") {
+    // Memory: the Rgb buffer takes 4 B/LED, the baked frame 96 B/LED
+    for (int count : { 100, 1000 }) {
+        auto frame = testFrame(count);
+        std::vector<uint32_t> baked(count * SYMBOLS_PER_PIXEL);
+        encodeSymbols(frame.data(), count, BIT0, BIT1, baked.data());
+
+        uint32_t rmtMem[RMT_MEM_WORDS];
+        uint32_t sink = 0;
+
+        BENCHMARK("encode " + std::to_string(count) + " LEDs (" + std::to_string(count * sizeof(Rgb)) + " B)") {
+            for (int i = 0; i < count; i += RMT_MEM_WORDS / SYMBOLS_PER_PIXEL) {
+                int n = std::min(RMT_MEM_WORDS / SYMBOLS_PER_PIXEL, count - i);
+                encodeSymbols(frame.data() + i, n, BIT0, BIT1, rmtMem);
+                sink += rmtMem[0];
+            }
+        }
+
+        BENCHMARK("copy baked " + std::to_string(count) + " LEDs (" + std::to_string(baked.size() * 4) + " B)") {
+            for (size_t i = 0; i < baked.size(); i += RMT_MEM_WORDS) {
+                size_t n = std::min<size_t>(RMT_MEM_WORDS, baked.size() - i);
+                std::copy_n(baked.data() + i, n, rmtMem);
+                sink += rmtMem[0];
+            }
+        }
+        REQUIRE(sink != 1);
+    }
+}
+
+TEST_CASE("Ordered encoding sends the pixels in the given order", "[symbols]") {
+    const int count = 16;
+    auto frame = testFrame(count);
+    std::vector<uint16_t> order(count);
+    std::vector<Rgb> permuted(count);
+    for (int i = 0; i != count; i++) {
+        order[i] = (i * 5 + 3) % count;
+        permuted[i] = frame[order[i]];
+        REQUIRE(detail::emittedPixel(frame.data(), order.data(), i) == permuted[i]);
+        REQUIRE(detail::emittedPixel(frame.data(), nullptr, i) == frame[i]);
+    }
+
+    std::vector<uint32_t> direct(count * SYMBOLS_PER_PIXEL), mapped(count * SYMBOLS_PER_PIXEL);
+    encodeSymbols(permuted.data(), count, BIT0, BIT1, direct.data());
+    auto* end = encodeSymbols(frame.data(), order.data(), count, BIT0, BIT1, mapped.data());
+    REQUIRE(end == mapped.data() + mapped.size());
+    REQUIRE(direct == mapped);
+}
+
+TEST_CASE("Permutation copy vs. ordered encoding", "[!benchmark][symbols]") {
+    const int count = 1024;
+    auto frame = testFrame(count);
+    std::vector<uint16_t> order(count);
+    for (int i = 0; i != count; i++)
+        order[i] = (i * 37) % count;
+    std::vector<Rgb> strip(count);
+    uint32_t rmtMem[RMT_MEM_WORDS];
+    uint32_t sink = 0;
+    const int perChunk = RMT_MEM_WORDS / SYMBOLS_PER_PIXEL;
+
+    BENCHMARK("copy into strip order, then encode, 1024 LEDs") {
+        for (int i = 0; i != count; i++)
+            strip[i] = frame[order[i]];
+        for (int i = 0; i < count; i += perChunk) {
+            encodeSymbols(strip.data() + i, std::min(perChunk, count - i), BIT0, BIT1, rmtMem);
+            sink += rmtMem[0];
+        }
+    }
+    BENCHMARK("encode through the order, 1024 LEDs") {
+        for (int i = 0; i < count; i += perChunk) {
+            encodeSymbols(frame.data(), order.data() + i, std::min(perChunk, count - i), BIT0, BIT1, rmtMem);
+            sink += rmtMem[0];
+        }
+    }
+    REQUIRE(sink != 1);
+}
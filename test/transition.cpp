@@ -0,0 +1,134 @@
+#include <Transition.h>
+#include <catch.hpp>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Solid : public Effect {
+    Rgb color;
+    int renders = 0;
+
+    Solid(Rgb color)
+        : color(color) {}
+
+    void render(LedSpan<Rgb> leds, uint32_t) override {
+        for (auto& p : leds)
+            p = color;
+        renders++;
+    }
+};
+
+std::vector<Rgb> gradient(int count, int seed) {
+    std::vector<Rgb> ret;
+    for (int i = 0; i != count; i++)
+        ret.emplace_back((i * 7 + seed) & 0xFF, (i * 13 + seed * 3) & 0xFF, (255 - i + seed) & 0xFF);
+    return ret;
+}
+
+} // namespace
+
+TEST_CASE("Crossfade matches the per-channel interpolation", "[transition]") {
+    const int count = 256;
+    auto from = gradient(count, 1), to = gradient(count, 77);
+    std::vector<Rgb> dest(count);
+    for (int frac = 0; frac != 256; frac++) {
+        crossfade(dest.data(), from.data(), to.data(), count, frac);
+        const double t = (frac + (frac >> 7)) / 256.0;
+        for (int i = 0; i != count; i++) {
+            CAPTURE(frac, i);
+            REQUIRE(std::abs(dest[i].r - (from[i].r + (to[i].r - from[i].r) * t)) < 1);
+            REQUIRE(std::abs(dest[i].g - (from[i].g + (to[i].g - from[i].g) * t)) < 1);
+            REQUIRE(std::abs(dest[i].b - (from[i].b + (to[i].b - from[i].b) * t)) < 1);
+            REQUIRE(dest[i].a == 255);
+        }
+    }
+    crossfade(dest.data(), from.data(), to.data(), count, 0);
+    REQUIRE(dest == from);
+    crossfade(dest.data(), from.data(), to.data(), count, 255);
+    REQUIRE(dest == to);
+}
+
+TEST_CASE("Wipe and dissolve", "[transition]") {
+    const int count = 100;
+    std::vector<Rgb> from(count, Rgb(0, 0, 0)), to(count, Rgb(200, 200, 200)), dest(count);
+
+    wipe(dest.data(), from.data(), to.data(), count, 128);
+    REQUIRE(dest[49] == to[49]);
+    // The edge pixel is partially blended
+    REQUIRE(dest[50].r > 0);
+    REQUIRE(dest[50].r < 200);
+    REQUIRE(dest[51] == from[51]);
+    REQUIRE(dest[99] == from[99]);
+    wipe(dest.data(), from.data(), to.data(), count, 255);
+    REQUIRE(dest == to);
+    wipe(dest.data(), from.data(), to.data(), count, 0);
+    REQUIRE(dest == from);
+
+    int switched = 0;
+    dissolve(dest.data(), from.data(), to.data(), count, 128, 42);
+    for (auto& p : dest)
+        switched += p == to[0];
+    CAPTURE(switched);
+    REQUIRE(switched > 35);
+    REQUIRE(switched < 65);
+
+    // More progress only switches more pixels
+    std::vector<Rgb> later(count);
+    dissolve(later.data(), from.data(), to.data(), count, 200, 42);
+    for (int i = 0; i != count; i++)
+        REQUIRE((dest[i] == to[i]) <= (later[i] == to[i]));
+    dissolve(dest.data(), from.data(), to.data(), count, 255, 42);
+    REQUIRE(dest == to);
+}
+
+TEST_CASE("Transition renders the outgoing effect at a reduced rate", "[transition]") {
+    const int count = 10;
+    std::vector<Rgb> pixels(count);
+    LedSpan<Rgb> leds(pixels.data(), count);
+    Solid red(Rgb(200, 0, 0)), blue(Rgb(0, 0, 200));
+    Transition transition(count);
+
+    transition.show(red);
+    transition.render(leds, 0);
+    REQUIRE(pixels[0] == red.color);
+
+    transition.start(blue, TransitionCrossfade, 1000, 100, 4);
+    REQUIRE(transition.active(100));
+    red.renders = blue.renders = 0;
+    for (uint32_t t = 100; t < 1100; t += 10)
+        transition.render(leds, t);
+    REQUIRE(blue.renders == 100);
+    REQUIRE(red.renders == 25);
+
+    transition.render(leds, 1100);
+    REQUIRE_FALSE(transition.active(1100));
+    REQUIRE(pixels[0] == blue.color);
+
+    transition.start(red, TransitionCrossfade, 1000, 2000);
+    transition.render(leds, 2500);
+    REQUIRE(transition.progress(2500) == 127);
+    REQUIRE(std::abs(pixels[0].r - 100) <= 1);
+    REQUIRE(std::abs(pixels[0].b - 100) <= 1);
+}
+
+TEST_CASE("Crossfade kernel vs. Rgb::blend", "[!benchmark][transition]") {
+    const int count = 1000;
+    auto from = gradient(count, 1), to = gradient(count, 77);
+    std::vector<Rgb> dest(count);
+    uint8_t frac = 0;
+
+    BENCHMARK("Rgb::blend, 1000 LEDs") {
+        for (int i = 0; i != count; i++) {
+            dest[i] = from[i];
+            Rgb in = to[i];
+            in.a = frac;
+            dest[i].a = 255 - frac;
+            dest[i].blend(in);
+        }
+        frac++;
+    }
+    BENCHMARK("crossfade, 1000 LEDs") { crossfade(dest.data(), from.data(), to.data(), count, frac++); }
+    BENCHMARK("dissolve, 1000 LEDs") { dissolve(dest.data(), from.data(), to.data(), count, frac++); }
+    REQUIRE(dest[0].a == 255);
+}